@@ -1,4 +1,10 @@
 #include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+
+#include "tree_stats.h"
 
 struct Node {
     int height;
@@ -12,8 +18,12 @@ struct Node {
 };
 
 class AVLTree {
+    // Высота AVL-дерева не больше 1.45 * log2(n + 2), для int-размера это меньше 48.
+    static constexpr int kMaxHeight = 64;
+
     Node* root_;
     int size_;
+    TreeCounters counters_;
 
     void deleteNode(Node* node) {
         if (node == nullptr) {
@@ -31,268 +41,208 @@ class AVLTree {
         return node->height;
     }
 
-    bool isBalanced(Node* node) {
-        return !node || abs(node->balance_factor) <= 1;
-    }
-
     void update(Node* node) {
-        if (!node) {
-            return;
-        }
         int r_height = getDepth(node->right);
         int l_height = getDepth(node->left);
         node->balance_factor = r_height - l_height;
         node->height = std::max(r_height, l_height) + 1;
     }
 
-    void rightRotation(Node* grandpa, Node* pa, bool is_right) {
+    // Повороты подменяют поддерево прямо в ссылке link, на которой оно висит.
+    void rightRotation(Node*& link) {
+        counters_.addRotation();
+        Node* pa = link;
         Node* node = pa->left;
-        if (grandpa) {
-            if (is_right) {
-                grandpa->right = node;
-            } else {
-                grandpa->left = node;
-            }
-        }
         pa->left = node->right;
         node->right = pa;
         update(pa);
         update(node);
+        link = node;
     }
 
-    void leftRotation(Node* grandpa, Node* pa, bool is_right) {
+    void leftRotation(Node*& link) {
+        counters_.addRotation();
+        Node* pa = link;
         Node* node = pa->right;
-        if (grandpa) {
-            if (is_right) {
-                grandpa->right = node;
-            } else {
-                grandpa->left = node;
-            }
-        }
         pa->right = node->left;
         node->left = pa;
         update(pa);
         update(node);
+        link = node;
     }
 
-    void balance(Node* node) {
-        if (!isBalanced(node->left)) {
-            if (node->left->balance_factor > 0) {
-                if (node->left->right->balance_factor < 0) {
-                    rightRotation(node->left, node->left->right, true);
-                }
-                leftRotation(node, node->left, false);
-            } else {
-                if (node->left->left->balance_factor > 0) {
-                    leftRotation(node->left, node->left->left, false);
-                }
-                rightRotation(node, node->left, false);
+    // Пересчитывает вершину в link и при перекосе на 2 делает одинарный или двойной поворот.
+    void balance(Node*& link) {
+        Node* node = link;
+        update(node);
+        if (node->balance_factor > 1) {
+            if (node->right->balance_factor < 0) {
+                rightRotation(node->right);
             }
-        }
-        if (!isBalanced(node->right)) {
-            if (node->right->balance_factor > 0) {
-                if (node->right->right->balance_factor < 0) {
-                    rightRotation(node->right, node->right->right, true);
-                }
-                leftRotation(node, node->right, true);
-            } else {
-                if (node->right->left->balance_factor > 0) {
-                    leftRotation(node->right, node->right->left, false);
-                }
-                rightRotation(node, node->right, true);
+            leftRotation(link);
+        } else if (node->balance_factor < -1) {
+            if (node->left->balance_factor > 0) {
+                leftRotation(node->left);
             }
+            rightRotation(link);
         }
-        update(node);
     }
 
-    void balanceRoot() {
-        Node* root = root_;
-        if (!isBalanced(root)) {
-            if (root->balance_factor > 0) {
-                if (root->right->balance_factor < 0) {
-                    rightRotation(root, root->right, false);
-                }
-                root_ = root->right;
-                leftRotation(nullptr, root, false);
-            } else {
-                if (root->left->balance_factor > 0) {
-                    leftRotation(root, root->left, false);
-                }
-                root_ = root->left;
-                rightRotation(nullptr, root, false);
+    // Идёт по пути снизу вверх и останавливается на первом поддереве, высота
+    // которого не изменилась: выше него дерево уже сбалансировано.
+    void retrace(Node** path[], int depth) {
+        while (depth > 0) {
+            Node*& link = *path[--depth];
+            int old_height = link->height;
+            balance(link);
+            if (link->height == old_height) {
+                return;
             }
         }
-        update(root_);
     }
 
-    void add(Node* current, int new_val) {
-        if (current->value == new_val) {
-            return;
-        }
-
-        if (new_val > current->value) {
-            if (current->right == nullptr) {
-                current->right = new Node(new_val);
-                ++size_;
-            } else {
-                add(current->right, new_val);
-            }
-        } else {
-            if (current->left == nullptr) {
-                current->left = new Node(new_val);
-                ++size_;
-            } else {
-                add(current->left, new_val);
+    // Спускается к value, складывая в path ссылки на пройденные вершины. Возвращает
+    // ссылку, где value лежит или должно лежать.
+    Node** findLink(int value, Node** path[], int& depth) {
+        Node** link = &root_;
+        depth = 0;
+        while (*link) {
+            counters_.addComparison();
+            if ((*link)->value == value) {
+                break;
             }
+            path[depth++] = link;
+            link = value < (*link)->value ? &(*link)->left : &(*link)->right;
         }
-
-        int l_depth, r_depth;
-        l_depth = getDepth(current->left);
-        r_depth = getDepth(current->right);
-        current->balance_factor = r_depth - l_depth;
-        balance(current);
+        return link;
     }
 
-    Node* maxLess(Node* start) {
-        Node* current = start->left;
-        while (current->right && current->right->right) {
-            current = current->right;
+    // Возвращает высоту поддерева, lo и hi — исключающие границы значений.
+    int auditNode(const Node* node, const int* lo, const int* hi, int& count) const {
+        if (!node) {
+            return 0;
+        }
+        ++count;
+        if ((lo && node->value <= *lo) || (hi && node->value >= *hi)) {
+            throw std::logic_error("AVLTree audit: values out of order");
+        }
+        int l_height = auditNode(node->left, lo, &node->value, count);
+        int r_height = auditNode(node->right, &node->value, hi, count);
+        if (node->height != std::max(l_height, r_height) + 1) {
+            throw std::logic_error("AVLTree audit: stale height");
+        }
+        if (node->balance_factor != r_height - l_height) {
+            throw std::logic_error("AVLTree audit: stale balance factor");
         }
-        return current;
+        if (abs(node->balance_factor) > 1) {
+            throw std::logic_error("AVLTree audit: node is out of balance");
+        }
+        return node->height;
     }
 
-    void newHeight(Node* border, Node* current) {
-        if (current == border) {
-            current->height = std::max(getDepth(current->left), getDepth(current->right)) + 1;
+    void subMas(Node* sub_tree, int* mas, int& curr) const {
+        if (!sub_tree) {
             return;
         }
-        if (current != border && border->value > current->value) {
-            newHeight(border, current->right);
-        } else {
-            newHeight(border, current->left);
+        if (sub_tree->left) {
+            subMas(sub_tree->left, mas, curr);
+        }
+        mas[curr++] = sub_tree->value;
+        if (sub_tree->right) {
+            subMas(sub_tree->right, mas, curr);
         }
-        current->height = std::max(getDepth(current->left), getDepth(current->right)) + 1;
     }
 
-    void remove(Node* pa, Node* to_del, bool is_right) {
-        --size_;
-        // Если это лист.
-        if (!to_del->left && !to_del->right) {
-            if (pa) {
-                if (is_right) {
-                    pa->right = nullptr;
-                } else {
-                    pa->left = nullptr;
-                }
-                newHeight(pa, root_);
-            } else {
-                root_ = nullptr;
-            }
-            delete to_del;
-            return;
+public:
+    // Двунаправленный итератор по возрастанию. В Node нет ссылки на родителя, поэтому
+    // итератор хранит путь от корня до текущей вершины; ++end() даёт первый элемент.
+    struct Iterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int*;
+        using reference = const int&;
+
+        Iterator() : root_(nullptr), depth_(0) {
+        }
+        explicit Iterator(const Node* root) : root_(root), depth_(0) {
         }
 
-        // Только правый потомок.
-        if (!to_del->left) {
-            if (pa) {
-                if (is_right) {
-                    pa->right = to_del->right;
-                } else {
-                    pa->left = to_del->right;
-                }
-                newHeight(pa, root_);
-            } else {
-                root_ = to_del->right;
-            }
-            delete to_del;
-            return;
+        const int& operator*() const {
+            return path_[depth_ - 1]->value;
+        }
+        const int* operator->() const {
+            return &path_[depth_ - 1]->value;
         }
 
-        // Только левый потомок.
-        if (!to_del->right) {
-            if (pa) {
-                if (is_right) {
-                    pa->right = to_del->left;
-                } else {
-                    pa->left = to_del->left;
-                }
-                newHeight(pa, root_);
+        Iterator& operator++() {
+            if (depth_ == 0) {
+                descendLeft(root_);
+            } else if (path_[depth_ - 1]->right) {
+                descendLeft(path_[depth_ - 1]->right);
             } else {
-                root_ = to_del->left;
+                // Поднимаемся, пока приходим из правого поддерева.
+                const Node* child;
+                do {
+                    child = path_[--depth_];
+                } while (depth_ > 0 && path_[depth_ - 1]->right == child);
             }
-            delete to_del;
-            return;
+            return *this;
         }
-
-        // Оба потомка.
-        Node* node = maxLess(to_del);
-        Node* replace;
-        if (!node->right) {
-            replace = node;
-        } else {
-            replace = node->right;
-            node->right = replace->left;
-            replace->left = to_del->left;
+        Iterator operator++(int) {
+            Iterator copy_it(*this);
+            ++(*this);
+            return copy_it;
         }
 
-        if (pa) {
-            if (is_right) {
-                pa->right = replace;
+        Iterator& operator--() {
+            if (depth_ == 0) {
+                descendRight(root_);
+            } else if (path_[depth_ - 1]->left) {
+                descendRight(path_[depth_ - 1]->left);
             } else {
-                pa->left = replace;
+                const Node* child;
+                do {
+                    child = path_[--depth_];
+                } while (depth_ > 0 && path_[depth_ - 1]->left == child);
             }
-        } else {
-            root_ = replace;
+            return *this;
+        }
+        Iterator operator--(int) {
+            Iterator copy_it(*this);
+            --(*this);
+            return copy_it;
         }
-        replace->right = to_del->right;
-        newHeight(node, root_);
-        delete to_del;
-    }
 
-    void findToDel(Node* node, int val) {
-        if (!node) {
-            return;
+        bool operator==(const Iterator& other) const {
+            return current() == other.current();
         }
-        if (val > node->value) {
-            if (!node->right) {
-                return;
-            }
-            if (node->right->value != val) {
-                findToDel(node->right, val);
-            } else {
-                remove(node, node->right, true);
-            }
-        } else if (val < node->value) {
-            if (!node->left) {
-                return;
-            }
-            if (node->left->value != val) {
-                findToDel(node->left, val);
-            } else {
-                remove(node, node->left, false);
-            }
-        } else {
-            // Сюда попадаем, если значение находится в корне.
-            remove(nullptr, node, false);
-            return;
+        bool operator!=(const Iterator& other) const {
+            return current() != other.current();
         }
-        balance(node);
-    }
 
-    void subMas(Node* sub_tree, int* mas, int& curr) const {
-        if (!sub_tree) {
-            return;
+    private:
+        friend class AVLTree;
+
+        const Node* current() const {
+            return depth_ > 0 ? path_[depth_ - 1] : nullptr;
         }
-        if (sub_tree->left) {
-            subMas(sub_tree->left, mas, curr);
+        void descendLeft(const Node* node) {
+            for (; node; node = node->left) {
+                path_[depth_++] = node;
+            }
         }
-        mas[curr++] = sub_tree->value;
-        if (sub_tree->right) {
-            subMas(sub_tree->right, mas, curr);
+        void descendRight(const Node* node) {
+            for (; node; node = node->right) {
+                path_[depth_++] = node;
+            }
         }
-    }
 
-public:
+        const Node* root_;
+        const Node* path_[kMaxHeight];
+        int depth_;
+    };
+
     AVLTree() : root_(nullptr), size_(0) {
     }
 
@@ -301,23 +251,61 @@ public:
     }
 
     void insert(int value) {
-        if (root_ == nullptr) {
-            ++size_;
-            root_ = new Node(value);
-        } else {
-            add(root_, value);
-            balanceRoot();
+        Node** path[kMaxHeight];
+        int depth;
+        Node** link = findLink(value, path, depth);
+        if (*link) {
+            return;
         }
+        *link = new Node(value);
+        ++size_;
+        retrace(path, depth);
     }
 
     void erase(int value) {
-        findToDel(root_, value);
-        balanceRoot();
+        Node** path[kMaxHeight];
+        int depth;
+        Node** link = findLink(value, path, depth);
+        Node* to_del = *link;
+        if (!to_del) {
+            return;
+        }
+        if (!to_del->left || !to_del->right) {
+            *link = to_del->left ? to_del->left : to_del->right;
+        } else {
+            // Две дочерние вершины: место to_del занимает следующая за ней.
+            path[depth++] = link;
+            int right_slot = depth;
+            Node** next_link = &to_del->right;
+            while ((*next_link)->left) {
+                path[depth++] = next_link;
+                next_link = &(*next_link)->left;
+            }
+            Node* next = *next_link;
+            *next_link = next->right;
+            next->left = to_del->left;
+            next->right = to_del->right;
+            // next целиком принимает состояние to_del: retrace может до него не дойти,
+            // а если дойдёт, сравнит с прежней высотой поддерева.
+            next->height = to_del->height;
+            next->balance_factor = to_del->balance_factor;
+            *link = next;
+            if (depth > right_slot) {
+                path[right_slot] = &next->right;
+            }
+        }
+        delete to_del;
+        --size_;
+        retrace(path, depth);
     }
 
     int* find(int value) {
         Node* current = root_;
-        while (current && current->value != value) {
+        while (current) {
+            counters_.addComparison();
+            if (current->value == value) {
+                break;
+            }
             if (current->value > value) {
                 current = current->left;
             } else {
@@ -348,6 +336,7 @@ public:
         if (current == nullptr) {
             return res;
         }
+        counters_.addComparison();
         if (current->value < value) {
             res = lowerBound(value, current->right, res);
         } else {
@@ -360,6 +349,58 @@ public:
         return size_ == 0;
     }
 
+    Iterator begin() const {
+        Iterator it(root_);
+        it.descendLeft(root_);
+        return it;
+    }
+    Iterator end() const {
+        return Iterator(root_);
+    }
+
+    // Обходит значения из [lo, hi) по возрастанию за O(log n + k), ничего не выделяя.
+    template <typename Callback>
+    void forEach(int lo, int hi, Callback callback) const {
+        Iterator last = end();
+        for (Iterator it = seek(lo); it != last && *it < hi; ++it) {
+            callback(*it);
+        }
+    }
+
+    // Пишет значения из [lo, hi) в out, пока он не заполнится; возвращает число записанных.
+    size_t copyRange(int lo, int hi, std::span<int> out) const {
+        size_t count = 0;
+        Iterator last = end();
+        for (Iterator it = seek(lo); count < out.size() && it != last && *it < hi; ++it) {
+            out[count++] = *it;
+        }
+        return count;
+    }
+
+    // Форма дерева обходом за O(n) и счётчики операций (см. TREE_STATS в tree_stats.h);
+    // black_height у AVL-дерева всегда 0.
+    TreeStats stats() const {
+        TreeStats res;
+        collectShape(root_, res);
+        res.bytes_used = sizeof(*this) + res.node_count * sizeof(Node);
+        counters_.fill(res);
+        return res;
+    }
+
+    void resetStats() {
+        counters_.reset();
+    }
+
+    // Проверяет порядок значений, высоты, факторы баланса и размер. Стоит O(n);
+    // при нарушении бросает std::logic_error.
+    void audit() const {
+        int count = 0;
+        auditNode(root_, nullptr, nullptr, count);
+        if (count != size_) {
+            throw std::logic_error("AVLTree audit: size mismatch");
+        }
+    }
+
     Node* getRoot() {
         return root_;
     }
@@ -371,4 +412,20 @@ public:
     ~AVLTree() {
         deleteNode(root_);
     }
-};
\ No newline at end of file
+
+private:
+    // Итератор на первое значение не меньше value.
+    Iterator seek(int value) const {
+        Iterator it(root_);
+        for (const Node* node = root_; node;) {
+            counters_.addComparison();
+            it.path_[it.depth_++] = node;
+            node = node->value < value ? node->right : node->left;
+        }
+        // Ниже искомой вершины путь проходит только по меньшим значениям.
+        while (it.depth_ > 0 && it.path_[it.depth_ - 1]->value < value) {
+            --it.depth_;
+        }
+        return it;
+    }
+};
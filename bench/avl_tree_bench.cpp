@@ -0,0 +1,48 @@
+#include <set>
+#include <string>
+
+#include "avl_tree.cpp"
+#include "bench/bench.h"
+
+// Нагрузка с преобладанием удалений: дерево заполняется, затем на каждую вставку
+// приходится два удаления, пока оно не опустеет. С -DTREE_STATS печатается и число поворотов.
+template <typename Tree>
+static void eraseHeavy(const char* name, const std::vector<int>& values) {
+    Tree tree;
+    long long sum = 0;
+    double ms = timeMs([&] {
+        for (int value : values) {
+            tree.insert(value);
+        }
+        size_t next = 0;
+        for (size_t i = 0; i < values.size(); ++i) {
+            tree.erase(values[i]);
+            if (i % 2 == 0 && next < values.size()) {
+                tree.insert(values[next++] ^ 1);
+            }
+        }
+        for (int value : values) {
+            tree.erase(value ^ 1);
+        }
+        if constexpr (requires { tree.getSize(); }) {
+            sum = tree.getSize();
+        } else {
+            sum = static_cast<long long>(tree.size());
+        }
+    });
+    std::string label = std::string(name) + " erase-heavy";
+    report(label.c_str(), ms, sum);
+#ifdef TREE_STATS
+    if constexpr (requires { tree.stats(); }) {
+        std::printf("%-44s %10llu\n", "  rotations",
+                    static_cast<unsigned long long>(tree.stats().rotations));
+    }
+#endif
+}
+
+int main(int argc, char** argv) {
+    double scale = benchScale(argc, argv);
+    std::vector<int> values = randomInts(scaled(2000000, scale), 9);
+    eraseHeavy<AVLTree>("AVLTree", values);
+    eraseHeavy<std::set<int>>("std::set", values);
+}
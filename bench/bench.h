@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Общее для замеров в bench/. Каждый замер — отдельная программа, сборка из корня репозитория:
+//   g++ -std=c++20 -O2 -DNDEBUG -I. bench/<name>.cpp -o <name> -pthread
+// Первый аргумент масштабирует размеры (по умолчанию 1), например 0.1 для быстрого прогона.
+// Рядом со временем печатается контрольная сумма, чтобы результат не выбросил оптимизатор.
+
+inline double benchScale(int argc, char** argv) {
+    return argc > 1 ? std::atof(argv[1]) : 1.0;
+}
+
+inline size_t scaled(size_t count, double scale) {
+    size_t res = static_cast<size_t>(static_cast<double>(count) * scale);
+    return res > 0 ? res : 1;
+}
+
+template <typename F>
+double timeMs(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+inline void report(const char* name, double ms, long long checksum) {
+    std::printf("%-44s %10.1f ms   (checksum %lld)\n", name, ms, checksum);
+}
+
+inline std::vector<int> randomInts(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<int> res(count);
+    for (int& value : res) {
+        value = static_cast<int>(rng() & 0x7fffffff);
+    }
+    return res;
+}
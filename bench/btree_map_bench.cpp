@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <string>
+
+#include "bench/bench.h"
+#include "btree_map.cpp"
+#include "map.cpp"
+
+// Одни и те же вставки, случайные поиски и полный проход для BTreeMap и Map. Поиски
+// повторяются kFindPasses раз и берётся лучшее время, чтобы шум не скрывал разницу.
+constexpr int kFindPasses = 3;
+
+template <typename M>
+static void run(const std::string& name, const std::vector<int>& keys,
+                const std::vector<int>& queries) {
+    M map;
+    std::string label = name + " insert";
+    long long sum = 0;
+    double ms = timeMs([&] {
+        for (int key : keys) {
+            map.insert(key, key);
+        }
+    });
+    report(label.c_str(), ms, static_cast<long long>(map.size()));
+
+    label = name + " find";
+    ms = 0;
+    for (int pass = 0; pass < kFindPasses; ++pass) {
+        sum = 0;
+        double pass_ms = timeMs([&] {
+            for (int key : queries) {
+                auto it = map.find(key);
+                if (it != map.end()) {
+                    sum += it->second;
+                }
+            }
+        });
+        ms = pass == 0 ? pass_ms : std::min(ms, pass_ms);
+    }
+    report(label.c_str(), ms, sum);
+
+    label = name + " scan";
+    sum = 0;
+    ms = timeMs([&] {
+        for (const auto& entry : map) {
+            sum += entry.second;
+        }
+    });
+    report(label.c_str(), ms, sum);
+}
+
+// Выигрыш B-дерева в поиске — меньше промахов по кэшу, поэтому он возможен, только когда
+// словарь не помещается в кэш, и даже тогда невелик: основной выигрыш во вставке и проходе.
+// На 100 тысячах ключей всё лежит в кэше, и двоичный поиск внутри широкой вершины
+// обходится дороже спуска по указателям.
+int main(int argc, char** argv) {
+    double scale = benchScale(argc, argv);
+    std::vector<int> queries = randomInts(scaled(4000000, scale), 2);
+    for (size_t count : {size_t(100000), size_t(5000000)}) {
+        std::vector<int> keys = randomInts(scaled(count, scale), 1);
+        // Половина запросов попадает в существующие ключи.
+        std::vector<int> hits = queries;
+        for (size_t i = 0; i < hits.size(); i += 2) {
+            hits[i] = keys[hits[i] % keys.size()];
+        }
+        std::string suffix = ", " + std::to_string(keys.size()) + " keys";
+        run<BTreeMap<int, int>>("BTreeMap" + suffix, keys, hits);
+        run<Map<int, int>>("Map" + suffix, keys, hits);
+    }
+}
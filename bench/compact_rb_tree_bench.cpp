@@ -0,0 +1,66 @@
+#include <set>
+#include <string>
+
+#include "bench/bench.h"
+#include "compact_rb_tree.h"
+#include "rb_tree.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// Байт кучи на элемент после вставки всех значений (с учётом запаса вектора и блоков
+// аллокатора); считается через mallinfo2, поэтому только с glibc.
+template <typename Tree>
+static void heapPerElement(const char* name, const std::vector<int>& values) {
+#ifdef __GLIBC__
+    malloc_trim(0);
+    struct mallinfo2 before = mallinfo2();
+    Tree* tree = new Tree;
+    for (int value : values) {
+        tree->insert(value);
+    }
+    struct mallinfo2 after = mallinfo2();
+    size_t bytes = (after.uordblks + after.hblkhd) - (before.uordblks + before.hblkhd);
+    std::string label = std::string(name) + " heap bytes per element";
+    std::printf("%-44s %10.1f\n", label.c_str(),
+                static_cast<double>(bytes) / static_cast<double>(tree->size()));
+    delete tree;
+#else
+    (void)name;
+    (void)values;
+#endif
+}
+
+template <typename Tree>
+static void operations(const char* name, const std::vector<int>& values) {
+    Tree tree;
+    long long sum = 0;
+    double ms = timeMs([&] {
+        for (int value : values) {
+            tree.insert(value);
+        }
+        for (int value : values) {
+            sum += tree.find(value) != tree.end();
+        }
+        for (size_t i = 0; i < values.size(); i += 2) {
+            tree.erase(values[i]);
+        }
+        for (int value : tree) {
+            sum += value;
+        }
+    });
+    std::string label = std::string(name) + " insert, find, erase, scan";
+    report(label.c_str(), ms, sum);
+}
+
+int main(int argc, char** argv) {
+    double scale = benchScale(argc, argv);
+    std::vector<int> values = randomInts(scaled(1000000, scale), 7);
+    heapPerElement<CompactRBTree<int>>("CompactRBTree", values);
+    heapPerElement<RBTree<int>>("RBTree", values);
+    heapPerElement<std::set<int>>("std::set", values);
+    operations<CompactRBTree<int>>("CompactRBTree", values);
+    operations<RBTree<int>>("RBTree", values);
+    operations<std::set<int>>("std::set", values);
+}
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "bench/bench.h"
+#include "concurrent_map.cpp"
+
+// Смешанная нагрузка (90% поисков, 10% вставок и удалений) делится поровну между потоками.
+// Словарь без границ — один шард, то есть обычный Map под одним мьютексом; с ним
+// сравнивается разбиение на 64 шарда. Ускорение от потоков видно только на многоядерной машине.
+static double run(ConcurrentMap<int, int>& map, size_t threads, size_t ops, int range,
+                  long long& checksum) {
+    std::atomic<long long> hits{0};
+    double ms = timeMs([&] {
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::mt19937 rng(static_cast<unsigned>(t) + 1);
+                long long local = 0;
+                for (size_t i = 0; i < ops / threads; ++i) {
+                    int key = static_cast<int>(rng() % range);
+                    unsigned kind = rng() % 20;
+                    if (kind == 0) {
+                        map.insert(key, key);
+                    } else if (kind == 1) {
+                        map.erase(key);
+                    } else {
+                        local += map.contains(key);
+                    }
+                }
+                hits += local;
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    });
+    checksum = hits;
+    return ms;
+}
+
+int main(int argc, char** argv) {
+    double scale = benchScale(argc, argv);
+    const int range = static_cast<int>(scaled(1000000, scale));
+    const size_t ops = scaled(4000000, scale);
+    std::vector<int> boundaries;
+    for (int i = 1; i < 64; ++i) {
+        boundaries.push_back(static_cast<int>(static_cast<long long>(range) * i / 64));
+    }
+    size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        for (bool sharded : {false, true}) {
+            ConcurrentMap<int, int> map(sharded ? boundaries : std::vector<int>());
+            for (int key = 0; key < range; key += 2) {
+                map.insert(key, key);
+            }
+            long long checksum = 0;
+            double ms = run(map, threads, ops, range, checksum);
+            std::string label = std::string(sharded ? "64 shards, " : "1 shard, ") +
+                                std::to_string(threads) + " threads";
+            report(label.c_str(), ms, checksum);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#include <algorithm>
+
+#include "bench/bench.h"
+#include "intrusive_rb_tree.h"
+#include "rb_tree.h"
+
+// 56-байтные записи вставляются в перемешанном порядке и затем удаляются, три круга.
+// Интрузивное дерево только связывает уже существующие объекты и удаляет без поиска;
+// RBTree копирует запись в свою вершину и ищет её при удалении.
+struct Record {
+    long key;
+    long payload[6];
+    RBHook<Record> hook;
+
+    bool operator<(const Record& other) const {
+        return key < other.key;
+    }
+};
+
+struct PlainRecord {
+    long key;
+    long payload[6];
+
+    bool operator<(const PlainRecord& other) const {
+        return key < other.key;
+    }
+};
+
+int main(int argc, char** argv) {
+    double scale = benchScale(argc, argv);
+    const size_t count = scaled(2000000, scale);
+    const int rounds = 3;
+    std::vector<Record> records(count);
+    for (size_t i = 0; i < count; ++i) {
+        records[i].key = static_cast<long>(i);
+    }
+    std::shuffle(records.begin(), records.end(), std::mt19937(8));
+    std::vector<PlainRecord> plain(count);
+    for (size_t i = 0; i < count; ++i) {
+        plain[i].key = records[i].key;
+    }
+
+    long long sum = 0;
+    double ms = timeMs([&] {
+        IntrusiveRBTree<Record, &Record::hook> tree;
+        for (int round = 0; round < rounds; ++round) {
+            for (Record& record : records) {
+                tree.insert(record);
+            }
+            sum += static_cast<long long>(tree.size());
+            for (Record& record : records) {
+                tree.erase(record);
+            }
+        }
+    });
+    report("IntrusiveRBTree insert + erase", ms, sum);
+
+    sum = 0;
+    ms = timeMs([&] {
+        RBTree<PlainRecord> tree;
+        for (int round = 0; round < rounds; ++round) {
+            for (const PlainRecord& record : plain) {
+                tree.insert(record);
+            }
+            sum += static_cast<long long>(tree.size());
+            for (const PlainRecord& record : plain) {
+                tree.erase(record);
+            }
+        }
+    });
+    report("RBTree insert + erase", ms, sum);
+}
@@ -0,0 +1,173 @@
+#include <compare>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <string>
+
+#include "bench/bench.h"
+#include "map.cpp"
+
+// Выделения памяти считаются, чтобы проверить, что проход по Map их не делает.
+static long long allocations = 0;
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* res = std::malloc(size ? size : 1)) {
+        return res;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+// Проходы по всем элементам: разыменование итератора возвращает ссылку в вершину.
+static void scanBench(double scale) {
+    std::vector<int> keys = randomInts(scaled(1000000, scale), 1);
+    Map<int, int> map;
+    std::map<int, int> reference;
+    for (int key : keys) {
+        map.insert(key, key);
+        reference[key] = key;
+    }
+    const int passes = 5;
+    long long before = allocations;
+    long long sum = 0;
+    double ms = timeMs([&] {
+        for (int pass = 0; pass < passes; ++pass) {
+            for (auto it = map.begin(); it != map.end(); ++it) {
+                sum += it->first + (*it).second;
+            }
+        }
+    });
+    report("Map scan", ms, sum);
+    std::printf("%-44s %10lld\n", "  allocations during Map scan", allocations - before);
+    sum = 0;
+    ms = timeMs([&] {
+        for (int pass = 0; pass < passes; ++pass) {
+            for (auto it = reference.begin(); it != reference.end(); ++it) {
+                sum += it->first + (*it).second;
+            }
+        }
+    });
+    report("std::map scan", ms, sum);
+}
+
+// Случайные поиски в большом словаре: цикл find против пакетного findMany, в котором
+// спуски по нескольким ключам идут вперемешку и подгружают вершины заранее.
+static void findManyBench(double scale) {
+    std::vector<int> keys = randomInts(scaled(4000000, scale), 2);
+    std::vector<int> queries = randomInts(scaled(2000000, scale), 3);
+    for (size_t i = 0; i < queries.size(); i += 2) {
+        queries[i] = keys[queries[i] % keys.size()];
+    }
+    Map<int, int> map;
+    for (int key : keys) {
+        map.insert(key, key);
+    }
+    long long sum = 0;
+    double ms = timeMs([&] {
+        for (int key : queries) {
+            auto it = map.find(key);
+            if (it != map.end()) {
+                sum += it->second;
+            }
+        }
+    });
+    report("Map find loop", ms, sum);
+    std::vector<Map<int, int>::Iterator> found(queries.size());
+    sum = 0;
+    ms = timeMs([&] {
+        map.findMany(queries, found);
+        for (const auto& it : found) {
+            if (it != map.end()) {
+                sum += it->second;
+            }
+        }
+    });
+    report("Map findMany", ms, sum);
+}
+
+// Ключи с общим префиксом в 40 символов, чтобы сравнение было дорогим. Каждое сравнение
+// ключей считается: с operator<=> поиск делает одно сравнение на вершину, а ключ только
+// с operator< требует до двух вызовов на вершину.
+static long long key_comparisons = 0;
+
+struct ThreeWayKey {
+    std::string text;
+
+    bool operator<(const ThreeWayKey& other) const {
+        ++key_comparisons;
+        return text < other.text;
+    }
+    std::weak_ordering operator<=>(const ThreeWayKey& other) const {
+        ++key_comparisons;
+        int res = text.compare(other.text);
+        return res < 0 ? std::weak_ordering::less
+                       : res > 0 ? std::weak_ordering::greater : std::weak_ordering::equivalent;
+    }
+    bool operator==(const ThreeWayKey& other) const {
+        return text == other.text;
+    }
+};
+
+struct LessOnlyKey {
+    std::string text;
+
+    bool operator<(const LessOnlyKey& other) const {
+        ++key_comparisons;
+        return text < other.text;
+    }
+};
+
+template <typename MapType, typename Key>
+static void countComparisons(const char* name, const std::vector<std::string>& texts) {
+    MapType map;
+    key_comparisons = 0;
+    long long sum = 0;
+    double ms = timeMs([&] {
+        for (size_t i = 0; i < texts.size(); ++i) {
+            map.insert(Key{texts[i]}, static_cast<int>(i));
+        }
+        for (const std::string& text : texts) {
+            sum += map.find(Key{text})->second;
+        }
+    });
+    report(name, ms, sum);
+    std::printf("%-44s %10.1f\n", "  key comparisons per insert + find",
+                static_cast<double>(key_comparisons) / static_cast<double>(texts.size()));
+#ifdef TREE_STATS
+    if constexpr (requires { map.stats(); }) {
+        std::printf("%-44s %10llu\n", "  TreeStats::comparisons",
+                    static_cast<unsigned long long>(map.stats().comparisons));
+    }
+#endif
+}
+
+template <typename Key>
+struct StdMapAdapter : std::map<Key, int> {
+    void insert(const Key& key, int value) {
+        (*this)[key] = value;
+    }
+};
+
+static void comparisonBench(double scale) {
+    std::vector<int> numbers = randomInts(scaled(200000, scale), 4);
+    std::vector<std::string> texts;
+    for (int number : numbers) {
+        texts.push_back(std::string(40, 'k') + std::to_string(number));
+    }
+    countComparisons<Map<ThreeWayKey, int>, ThreeWayKey>("Map, key with <=>", texts);
+    countComparisons<Map<LessOnlyKey, int>, LessOnlyKey>("Map, key with < only", texts);
+    countComparisons<StdMapAdapter<LessOnlyKey>, LessOnlyKey>("std::map", texts);
+}
+
+int main(int argc, char** argv) {
+    double scale = benchScale(argc, argv);
+    scanBench(scale);
+    findManyBench(scale);
+    comparisonBench(scale);
+}
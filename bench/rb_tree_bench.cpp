@@ -0,0 +1,44 @@
+#include <set>
+#include <string>
+
+#include "bench/bench.h"
+#include "rb_tree.h"
+
+// Полные проходы вперёд и назад: шаг итератора RBTree — один переход по ссылке next/prev.
+template <typename Tree>
+static void scan(const char* name, const Tree& tree) {
+    const int passes = 5;
+    long long sum = 0;
+    double ms = timeMs([&] {
+        for (int pass = 0; pass < passes; ++pass) {
+            for (auto it = tree.begin(); it != tree.end(); ++it) {
+                sum += *it;
+            }
+        }
+    });
+    std::string label = std::string(name) + " forward scan";
+    report(label.c_str(), ms, sum);
+    sum = 0;
+    ms = timeMs([&] {
+        for (int pass = 0; pass < passes; ++pass) {
+            for (auto it = tree.end(); it != tree.begin();) {
+                sum += *--it;
+            }
+        }
+    });
+    label = std::string(name) + " backward scan";
+    report(label.c_str(), ms, sum);
+}
+
+int main(int argc, char** argv) {
+    double scale = benchScale(argc, argv);
+    std::vector<int> values = randomInts(scaled(5000000, scale), 6);
+    RBTree<int> tree;
+    std::set<int> reference;
+    for (int value : values) {
+        tree.insert(value);
+        reference.insert(value);
+    }
+    scan("RBTree", tree);
+    scan("std::set", reference);
+}
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+#include "bench/bench.h"
+#include "windowed_quantiles.cpp"
+
+// Окно из window отсчётов; на каждом такте приходит tick новых отсчётов и спрашиваются
+// p50, p90, p99 и p99.9. Для сравнения окно хранится в deque и сортируется на каждом такте.
+int main(int argc, char** argv) {
+    double scale = benchScale(argc, argv);
+    const size_t window = scaled(1000000, scale);
+    const size_t tick = scaled(10000, scale);
+    const int ticks = 20;
+    const std::vector<double> qs = {0.5, 0.9, 0.99, 0.999};
+    std::vector<int> samples = randomInts(window + tick * ticks, 5);
+
+    WindowedQuantiles<int> wq(window);
+    std::deque<int> recent;
+    for (size_t i = 0; i < window; ++i) {
+        wq.add(samples[i]);
+        recent.push_back(samples[i]);
+    }
+
+    long long sum = 0;
+    std::vector<int> out(qs.size());
+    double ms = timeMs([&] {
+        for (int t = 0; t < ticks; ++t) {
+            for (size_t i = 0; i < tick; ++i) {
+                wq.add(samples[window + t * tick + i]);
+            }
+            wq.quantiles(qs, out);
+            for (int value : out) {
+                sum += value;
+            }
+        }
+    });
+    report("WindowedQuantiles", ms, sum);
+
+    sum = 0;
+    std::vector<int> sorted;
+    ms = timeMs([&] {
+        for (int t = 0; t < ticks; ++t) {
+            for (size_t i = 0; i < tick; ++i) {
+                recent.pop_front();
+                recent.push_back(samples[window + t * tick + i]);
+            }
+            sorted.assign(recent.begin(), recent.end());
+            std::sort(sorted.begin(), sorted.end());
+            for (double q : qs) {
+                sum += sorted[static_cast<size_t>(std::floor(q * (sorted.size() - 1)))];
+            }
+        }
+    });
+    report("sort on every tick", ms, sum);
+}
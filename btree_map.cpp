@@ -0,0 +1,573 @@
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Упорядоченный словарь на B+-дереве с тем же интерфейсом, что и Map.
+// Вершина занимает несколько кэш-линий, а ключи внутренних вершин лежат подряд,
+// поэтому поиск делает O(log_B n) промахов по кэшу вместо O(log n).
+// Ключи-разделители во внутренних вершинах требуют от K конструктора по умолчанию
+// и присваивания.
+template <typename K, typename V, typename Compare = std::less<K>>
+class BTreeMap {
+    static constexpr size_t kNodeBytes = 256;
+    using Value = std::pair<const K, V>;
+
+    static constexpr size_t kLeafSlots = std::max<size_t>(4, kNodeBytes / sizeof(Value));
+    static constexpr size_t kInnerSlots =
+        std::max<size_t>(4, kNodeBytes / (sizeof(K) + sizeof(void*)));
+    static constexpr size_t kMinLeaf = kLeafSlots / 2;
+    static constexpr size_t kMinInner = kInnerSlots / 2;
+    static constexpr size_t kMaxHeight = 64;
+
+    struct NodeBase {
+        size_t count = 0;
+    };
+
+    // Лишний слот позволяет сначала вставить элемент, а потом разделить вершину.
+    // Ключ в паре константный, как у Map, поэтому элементы лежат в сырой памяти
+    // и при сдвигах пересоздаются на новом месте (см. relocate).
+    struct Leaf : NodeBase {
+        Leaf* prev = nullptr;
+        Leaf* next = nullptr;
+        alignas(Value) unsigned char storage[(kLeafSlots + 1) * sizeof(Value)];
+
+        Leaf() {
+        }
+        Leaf(const Leaf&) = delete;
+        Leaf& operator=(const Leaf&) = delete;
+        ~Leaf() {
+            std::destroy(slots(), slots() + this->count);
+        }
+
+        Value* slots() {
+            return std::launder(reinterpret_cast<Value*>(storage));
+        }
+        const Value* slots() const {
+            return std::launder(reinterpret_cast<const Value*>(storage));
+        }
+    };
+
+    // count - число ключей, детей на одного больше.
+    struct Inner : NodeBase {
+        K keys[kInnerSlots + 1];
+        NodeBase* children[kInnerSlots + 2];
+    };
+
+    struct PathEntry {
+        Inner* node;
+        size_t index;
+    };
+
+public:
+    struct Iterator {
+        Iterator() : leaf_(nullptr), pos_(0), tree_(nullptr) {
+        }
+        Iterator(const Leaf* leaf, size_t pos, const BTreeMap* tree)
+            : leaf_(leaf), pos_(pos), tree_(tree) {
+        }
+
+        const std::pair<const K, V>& operator*() const {
+            return leaf_->slots()[pos_];
+        }
+        const std::pair<const K, V>* operator->() const {
+            if (!leaf_) {
+                return nullptr;
+            }
+            return &leaf_->slots()[pos_];
+        }
+
+        Iterator& operator++() {
+            if (!leaf_) {
+                leaf_ = tree_ ? tree_->head_ : nullptr;
+                pos_ = 0;
+                return *this;
+            }
+            if (++pos_ == leaf_->count) {
+                leaf_ = leaf_->next;
+                pos_ = 0;
+            }
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator copy_it(*this);
+            ++(*this);
+            return copy_it;
+        }
+
+        Iterator& operator--() {
+            if (!leaf_ || pos_ == 0) {
+                leaf_ = leaf_ ? leaf_->prev : (tree_ ? tree_->tail_ : nullptr);
+                pos_ = leaf_ ? leaf_->count - 1 : 0;
+                return *this;
+            }
+            --pos_;
+            return *this;
+        }
+        Iterator operator--(int) {
+            Iterator copy_it(*this);
+            --(*this);
+            return copy_it;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return leaf_ == other.leaf_ && pos_ == other.pos_;
+        }
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const Leaf* leaf_;
+        size_t pos_;
+        const BTreeMap* tree_;
+    };
+
+    BTreeMap() : root_(nullptr), head_(nullptr), tail_(nullptr), height_(0), size_(0) {
+    }
+    explicit BTreeMap(const Compare& comp)
+        : root_(nullptr), head_(nullptr), tail_(nullptr), height_(0), size_(0), comp_(comp) {
+    }
+    BTreeMap(std::initializer_list<std::pair<K, V>> list) : BTreeMap() {
+        for (const auto& [key, val] : list) {
+            insert(key, val);
+        }
+    }
+    BTreeMap(const BTreeMap& other) : BTreeMap(other.comp_) {
+        copyFrom(other);
+    }
+
+    BTreeMap& operator=(const BTreeMap& other) {
+        if (this != &other) {
+            clear();
+            comp_ = other.comp_;
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    ~BTreeMap() {
+        clear();
+    }
+
+    void clear() {
+        destroyNode(root_, 0);
+        root_ = nullptr;
+        head_ = tail_ = nullptr;
+        height_ = 0;
+        size_ = 0;
+    }
+
+    void insert(const K& key, const V& value) {
+        insertOrAssign(key, value);
+    }
+
+    template <typename KeyArg, typename ValueArg>
+    std::pair<Iterator, bool> insertOrAssign(KeyArg&& key, ValueArg&& value) {
+        if (!root_) {
+            root_ = head_ = tail_ = new Leaf();
+        }
+        PathEntry path[kMaxHeight];
+        Leaf* leaf = descend(key, path);
+        Value* slots = leaf->slots();
+        size_t pos = lowerIndex(leaf, key);
+        if (pos < leaf->count && !comp_(key, slots[pos].first)) {
+            slots[pos].second = std::forward<ValueArg>(value);
+            return {Iterator(leaf, pos, this), false};
+        }
+
+        relocate(slots + pos, slots + leaf->count, slots + pos + 1);
+        std::construct_at(slots + pos, std::forward<KeyArg>(key), std::forward<ValueArg>(value));
+        ++leaf->count;
+        ++size_;
+        if (leaf->count <= kLeafSlots) {
+            return {Iterator(leaf, pos, this), true};
+        }
+
+        // Переполненный лист делится пополам, первый ключ правой половины уходит в родителя.
+        Leaf* right = new Leaf();
+        size_t half = leaf->count / 2;
+        relocate(slots + half, slots + leaf->count, right->slots());
+        right->count = leaf->count - half;
+        leaf->count = half;
+        right->prev = leaf;
+        right->next = leaf->next;
+        if (leaf->next) {
+            leaf->next->prev = right;
+        } else {
+            tail_ = right;
+        }
+        leaf->next = right;
+        insertIntoParent(path, height_, right->slots()[0].first, right);
+        if (pos >= half) {
+            return {Iterator(right, pos - half, this), true};
+        }
+        return {Iterator(leaf, pos, this), true};
+    }
+
+    void erase(const K& key) {
+        eraseKey(key);
+    }
+
+    template <typename KeyLike, typename C = Compare, typename = typename C::is_transparent>
+    void erase(const KeyLike& key) {
+        eraseKey(key);
+    }
+
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    Iterator lowerBound(const K& key) const {
+        return lowerBoundKey(key);
+    }
+
+    template <typename KeyLike, typename C = Compare, typename = typename C::is_transparent>
+    Iterator lowerBound(const KeyLike& key) const {
+        return lowerBoundKey(key);
+    }
+
+    Iterator find(const K& key) const {
+        return findKey(key);
+    }
+
+    template <typename KeyLike, typename C = Compare, typename = typename C::is_transparent>
+    Iterator find(const KeyLike& key) const {
+        return findKey(key);
+    }
+
+    Iterator begin() const {
+        return Iterator(head_, 0, this);
+    }
+    Iterator end() const {
+        return Iterator(nullptr, 0, this);
+    }
+
+private:
+    NodeBase* root_;
+    Leaf* head_;
+    Leaf* tail_;
+    // Число уровней внутренних вершин: на глубине height_ лежат листья.
+    size_t height_;
+    size_t size_;
+    Compare comp_;
+
+    // Переносит пары [first, last) в dest: пересоздаёт каждую на новом месте и разрушает
+    // старую. Ячейки dest, ещё не занятые переносом, должны быть пустыми; диапазоны
+    // внутри одного листа могут перекрываться.
+    static void relocate(Value* first, Value* last, Value* dest) {
+        if (std::less<>()(dest, first)) {
+            for (; first != last; ++first, ++dest) {
+                std::construct_at(dest, std::move(*first));
+                std::destroy_at(first);
+            }
+        } else {
+            Value* dest_last = dest + (last - first);
+            while (last != first) {
+                std::construct_at(--dest_last, std::move(*--last));
+                std::destroy_at(last);
+            }
+        }
+    }
+
+    template <typename KeyLike>
+    size_t upperIndex(const Inner* inner, const KeyLike& key) const {
+        return std::upper_bound(inner->keys, inner->keys + inner->count, key,
+                                [this](const KeyLike& k, const K& sep) { return comp_(k, sep); }) -
+               inner->keys;
+    }
+
+    template <typename KeyLike>
+    size_t lowerIndex(const Leaf* leaf, const KeyLike& key) const {
+        return std::lower_bound(
+                   leaf->slots(), leaf->slots() + leaf->count, key,
+                   [this](const Value& slot, const KeyLike& k) { return comp_(slot.first, k); }) -
+               leaf->slots();
+    }
+
+    template <typename KeyLike>
+    Leaf* descend(const KeyLike& key, PathEntry* path) const {
+        NodeBase* node = root_;
+        for (size_t level = 0; level < height_; ++level) {
+            Inner* inner = static_cast<Inner*>(node);
+            size_t index = upperIndex(inner, key);
+            if (path) {
+                path[level] = {inner, index};
+            }
+            node = inner->children[index];
+        }
+        return static_cast<Leaf*>(node);
+    }
+
+    template <typename KeyLike>
+    Iterator lowerBoundKey(const KeyLike& key) const {
+        if (!root_) {
+            return end();
+        }
+        Leaf* leaf = descend(key, nullptr);
+        size_t pos = lowerIndex(leaf, key);
+        if (pos == leaf->count) {
+            return Iterator(leaf->next, 0, this);
+        }
+        return Iterator(leaf, pos, this);
+    }
+
+    template <typename KeyLike>
+    Iterator findKey(const KeyLike& key) const {
+        if (!root_) {
+            return end();
+        }
+        Leaf* leaf = descend(key, nullptr);
+        size_t pos = lowerIndex(leaf, key);
+        if (pos == leaf->count || comp_(key, leaf->slots()[pos].first)) {
+            return end();
+        }
+        return Iterator(leaf, pos, this);
+    }
+
+    void insertIntoParent(PathEntry* path, size_t level, K separator, NodeBase* right) {
+        while (level > 0) {
+            Inner* pa = path[level - 1].node;
+            size_t index = path[level - 1].index;
+            std::move_backward(pa->keys + index, pa->keys + pa->count,
+                               pa->keys + pa->count + 1);
+            std::move_backward(pa->children + index + 1, pa->children + pa->count + 1,
+                               pa->children + pa->count + 2);
+            pa->keys[index] = std::move(separator);
+            pa->children[index + 1] = right;
+            ++pa->count;
+            if (pa->count <= kInnerSlots) {
+                return;
+            }
+
+            // Средний ключ поднимается выше, правая половина переезжает в новую вершину.
+            Inner* sibling = new Inner();
+            size_t mid = pa->count / 2;
+            std::move(pa->keys + mid + 1, pa->keys + pa->count, sibling->keys);
+            std::copy(pa->children + mid + 1, pa->children + pa->count + 1, sibling->children);
+            sibling->count = pa->count - mid - 1;
+            separator = std::move(pa->keys[mid]);
+            pa->count = mid;
+            right = sibling;
+            --level;
+        }
+
+        Inner* new_root = new Inner();
+        new_root->count = 1;
+        new_root->keys[0] = std::move(separator);
+        new_root->children[0] = root_;
+        new_root->children[1] = right;
+        root_ = new_root;
+        ++height_;
+    }
+
+    template <typename KeyLike>
+    void eraseKey(const KeyLike& key) {
+        if (!root_) {
+            return;
+        }
+        PathEntry path[kMaxHeight];
+        Leaf* leaf = descend(key, path);
+        size_t pos = lowerIndex(leaf, key);
+        Value* slots = leaf->slots();
+        if (pos == leaf->count || comp_(key, slots[pos].first)) {
+            return;
+        }
+        std::destroy_at(slots + pos);
+        relocate(slots + pos + 1, slots + leaf->count, slots + pos);
+        --leaf->count;
+        --size_;
+
+        if (height_ == 0) {
+            if (leaf->count == 0) {
+                delete leaf;
+                root_ = head_ = tail_ = nullptr;
+            }
+            return;
+        }
+        // Устаревший разделитель в родителе не мешает: он всё ещё отделяет поддеревья.
+        if (leaf->count < kMinLeaf) {
+            rebalanceLeaf(path, leaf);
+        }
+    }
+
+    void rebalanceLeaf(PathEntry* path, Leaf* leaf) {
+        Inner* pa = path[height_ - 1].node;
+        size_t index = path[height_ - 1].index;
+        Leaf* left = index > 0 ? static_cast<Leaf*>(pa->children[index - 1]) : nullptr;
+        Leaf* right = index < pa->count ? static_cast<Leaf*>(pa->children[index + 1]) : nullptr;
+
+        Value* slots = leaf->slots();
+        // Заём у левого соседа.
+        if (left && left->count > kMinLeaf) {
+            Value* left_slots = left->slots();
+            relocate(slots, slots + leaf->count, slots + 1);
+            relocate(left_slots + left->count - 1, left_slots + left->count, slots);
+            --left->count;
+            ++leaf->count;
+            pa->keys[index - 1] = slots[0].first;
+            return;
+        }
+        // Заём у правого соседа.
+        if (right && right->count > kMinLeaf) {
+            Value* right_slots = right->slots();
+            relocate(right_slots, right_slots + 1, slots + leaf->count);
+            ++leaf->count;
+            relocate(right_slots + 1, right_slots + right->count, right_slots);
+            --right->count;
+            pa->keys[index] = right_slots[0].first;
+            return;
+        }
+        // Слияние с соседом.
+        if (left) {
+            mergeLeaves(left, leaf);
+            removeFromInner(pa, index - 1);
+        } else {
+            mergeLeaves(leaf, right);
+            removeFromInner(pa, index);
+        }
+        rebalanceInner(path, height_ - 1);
+    }
+
+    void mergeLeaves(Leaf* left, Leaf* right) {
+        relocate(right->slots(), right->slots() + right->count, left->slots() + left->count);
+        left->count += right->count;
+        right->count = 0;
+        left->next = right->next;
+        if (right->next) {
+            right->next->prev = left;
+        } else {
+            tail_ = left;
+        }
+        delete right;
+    }
+
+    // Удаляет ключ index и ребёнка справа от него.
+    void removeFromInner(Inner* inner, size_t index) {
+        std::move(inner->keys + index + 1, inner->keys + inner->count, inner->keys + index);
+        std::copy(inner->children + index + 2, inner->children + inner->count + 1,
+                  inner->children + index + 1);
+        --inner->count;
+    }
+
+    void rebalanceInner(PathEntry* path, size_t level) {
+        while (true) {
+            Inner* node = path[level].node;
+            if (level == 0) {
+                if (node->count == 0) {
+                    root_ = node->children[0];
+                    delete node;
+                    --height_;
+                }
+                return;
+            }
+            if (node->count >= kMinInner) {
+                return;
+            }
+
+            Inner* pa = path[level - 1].node;
+            size_t index = path[level - 1].index;
+            Inner* left = index > 0 ? static_cast<Inner*>(pa->children[index - 1]) : nullptr;
+            Inner* right =
+                index < pa->count ? static_cast<Inner*>(pa->children[index + 1]) : nullptr;
+
+            // Поворот через родителя от левого соседа.
+            if (left && left->count > kMinInner) {
+                std::move_backward(node->keys, node->keys + node->count,
+                                   node->keys + node->count + 1);
+                std::copy_backward(node->children, node->children + node->count + 1,
+                                   node->children + node->count + 2);
+                node->keys[0] = std::move(pa->keys[index - 1]);
+                node->children[0] = left->children[left->count];
+                pa->keys[index - 1] = std::move(left->keys[left->count - 1]);
+                --left->count;
+                ++node->count;
+                return;
+            }
+            // Поворот через родителя от правого соседа.
+            if (right && right->count > kMinInner) {
+                node->keys[node->count] = std::move(pa->keys[index]);
+                node->children[node->count + 1] = right->children[0];
+                ++node->count;
+                pa->keys[index] = std::move(right->keys[0]);
+                std::move(right->keys + 1, right->keys + right->count, right->keys);
+                std::copy(right->children + 1, right->children + right->count + 1,
+                          right->children);
+                --right->count;
+                return;
+            }
+            if (left) {
+                mergeInner(left, node, pa, index - 1);
+            } else {
+                mergeInner(node, right, pa, index);
+            }
+            --level;
+        }
+    }
+
+    void mergeInner(Inner* left, Inner* right, Inner* pa, size_t sep) {
+        left->keys[left->count] = std::move(pa->keys[sep]);
+        std::move(right->keys, right->keys + right->count, left->keys + left->count + 1);
+        std::copy(right->children, right->children + right->count + 1,
+                  left->children + left->count + 1);
+        left->count += right->count + 1;
+        delete right;
+        removeFromInner(pa, sep);
+    }
+
+    void destroyNode(NodeBase* node, size_t level) {
+        if (!node) {
+            return;
+        }
+        if (level == height_) {
+            delete static_cast<Leaf*>(node);
+            return;
+        }
+        Inner* inner = static_cast<Inner*>(node);
+        for (size_t i = 0; i <= inner->count; ++i) {
+            destroyNode(inner->children[i], level + 1);
+        }
+        delete inner;
+    }
+
+    NodeBase* copyNode(const NodeBase* node, size_t level, Leaf*& prev) {
+        if (level == height_) {
+            const Leaf* leaf = static_cast<const Leaf*>(node);
+            Leaf* copy = new Leaf();
+            std::uninitialized_copy(leaf->slots(), leaf->slots() + leaf->count, copy->slots());
+            copy->count = leaf->count;
+            copy->prev = prev;
+            if (prev) {
+                prev->next = copy;
+            } else {
+                head_ = copy;
+            }
+            prev = copy;
+            return copy;
+        }
+        const Inner* inner = static_cast<const Inner*>(node);
+        Inner* copy = new Inner();
+        std::copy(inner->keys, inner->keys + inner->count, copy->keys);
+        copy->count = inner->count;
+        for (size_t i = 0; i <= inner->count; ++i) {
+            copy->children[i] = copyNode(inner->children[i], level + 1, prev);
+        }
+        return copy;
+    }
+
+    void copyFrom(const BTreeMap& other) {
+        if (!other.root_) {
+            return;
+        }
+        height_ = other.height_;
+        Leaf* prev = nullptr;
+        root_ = copyNode(other.root_, 0, prev);
+        tail_ = prev;
+        size_ = other.size_;
+    }
+};
@@ -0,0 +1,429 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "three_way_compare.h"
+
+// Вершина компактного дерева: ссылки — 32-битные индексы в общем массиве,
+// старший бит ссылки на родителя хранит цвет. Для int это 16 байт на элемент.
+template <typename T>
+struct CompactNode {
+    T value;
+    uint32_t left;
+    uint32_t right;
+    uint32_t parent;
+};
+
+// Красно-чёрное дерево с тем же интерфейсом, что и RBTree из rb_tree.h, но с вершинами
+// в одном std::vector. Массив всегда плотный: при удалении на место удалённой вершины
+// переносится последняя, поэтому erase делает недействительными итераторы, как у вектора.
+template <typename ValueType>
+class CompactRBTree {
+    using Node = CompactNode<ValueType>;
+
+    static constexpr uint32_t kRedBit = uint32_t{1} << 31;
+    static constexpr uint32_t kNull = kRedBit - 1;
+
+public:
+    struct Iterator {
+        Iterator() : tree_(nullptr), index_(kNull) {
+        }
+        Iterator(const CompactRBTree* tree, uint32_t index) : tree_(tree), index_(index) {
+        }
+
+        const ValueType& operator*() const {
+            return tree_->nodes_[index_].value;
+        }
+        const ValueType* operator->() const {
+            return &tree_->nodes_[index_].value;
+        }
+
+        Iterator& operator++() {
+            if (index_ == kNull) {
+                index_ = tree_->mostLeft(tree_->root_);
+            } else if (tree_->right(index_) != kNull) {
+                index_ = tree_->mostLeft(tree_->right(index_));
+            } else {
+                uint32_t pa = tree_->parent(index_);
+                while (pa != kNull && tree_->right(pa) == index_) {
+                    index_ = pa;
+                    pa = tree_->parent(pa);
+                }
+                index_ = pa;
+            }
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator copy_it(*this);
+            ++(*this);
+            return copy_it;
+        }
+
+        Iterator& operator--() {
+            if (index_ == kNull) {
+                index_ = tree_->mostRight(tree_->root_);
+            } else if (tree_->left(index_) != kNull) {
+                index_ = tree_->mostRight(tree_->left(index_));
+            } else {
+                uint32_t pa = tree_->parent(index_);
+                while (pa != kNull && tree_->left(pa) == index_) {
+                    index_ = pa;
+                    pa = tree_->parent(pa);
+                }
+                index_ = pa;
+            }
+            return *this;
+        }
+        Iterator operator--(int) {
+            Iterator copy_it(*this);
+            --(*this);
+            return copy_it;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return index_ == other.index_ && tree_ == other.tree_;
+        }
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const CompactRBTree* tree_;
+        uint32_t index_;
+    };
+
+    CompactRBTree() : root_(kNull) {
+    }
+    CompactRBTree(std::initializer_list<ValueType> list) : CompactRBTree() {
+        for (const ValueType& val : list) {
+            insert(val);
+        }
+    }
+
+    void clear() {
+        nodes_.clear();
+        root_ = kNull;
+    }
+
+    void reserve(size_t count) {
+        nodes_.reserve(count);
+    }
+
+    // Байты, занятые массивом вершин, включая запас ёмкости.
+    size_t memoryUsage() const {
+        return nodes_.capacity() * sizeof(Node);
+    }
+
+    void insert(const ValueType& value) {
+        uint32_t pa = kNull;
+        uint32_t current = root_;
+        bool to_right = false;
+        while (current != kNull) {
+            auto order = threeWay(nodes_[current].value, value);
+            if (order == 0) {
+                return;
+            }
+            pa = current;
+            to_right = order < 0;
+            current = to_right ? right(current) : left(current);
+        }
+        if (nodes_.size() >= kNull) {
+            throw std::length_error("CompactRBTree: too many elements");
+        }
+        uint32_t node = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back({value, kNull, kNull, pa | kRedBit});
+        if (pa == kNull) {
+            root_ = node;
+        } else if (to_right) {
+            nodes_[pa].right = node;
+        } else {
+            nodes_[pa].left = node;
+        }
+        balance(node);
+    }
+
+    void erase(const ValueType& value) {
+        uint32_t node = findNode(value);
+        if (node != kNull) {
+            eraseNode(node);
+        }
+    }
+
+    size_t size() const {
+        return nodes_.size();
+    }
+    bool empty() const {
+        return nodes_.empty();
+    }
+
+    Iterator lowerBound(const ValueType& value) const {
+        uint32_t res = kNull;
+        uint32_t current = root_;
+        while (current != kNull) {
+            if (nodes_[current].value < value) {
+                current = right(current);
+            } else {
+                res = current;
+                current = left(current);
+            }
+        }
+        return Iterator(this, res);
+    }
+
+    Iterator find(const ValueType& value) const {
+        return Iterator(this, findNode(value));
+    }
+
+    Iterator begin() const {
+        return Iterator(this, mostLeft(root_));
+    }
+    Iterator end() const {
+        return Iterator(this, kNull);
+    }
+
+private:
+    std::vector<Node> nodes_;
+    uint32_t root_;
+
+    uint32_t left(uint32_t node) const {
+        return nodes_[node].left;
+    }
+    uint32_t right(uint32_t node) const {
+        return nodes_[node].right;
+    }
+    uint32_t parent(uint32_t node) const {
+        return nodes_[node].parent & ~kRedBit;
+    }
+    void setParent(uint32_t node, uint32_t pa) {
+        nodes_[node].parent = (nodes_[node].parent & kRedBit) | pa;
+    }
+
+    bool isRed(uint32_t node) const {
+        return node != kNull && (nodes_[node].parent & kRedBit);
+    }
+    bool isBlack(uint32_t node) const {
+        return !isRed(node);
+    }
+    void setRed(uint32_t node, bool red) {
+        if (red) {
+            nodes_[node].parent |= kRedBit;
+        } else {
+            nodes_[node].parent &= ~kRedBit;
+        }
+    }
+
+    uint32_t mostLeft(uint32_t node) const {
+        if (node == kNull) {
+            return kNull;
+        }
+        while (left(node) != kNull) {
+            node = left(node);
+        }
+        return node;
+    }
+
+    uint32_t mostRight(uint32_t node) const {
+        if (node == kNull) {
+            return kNull;
+        }
+        while (right(node) != kNull) {
+            node = right(node);
+        }
+        return node;
+    }
+
+    uint32_t findNode(const ValueType& value) const {
+        uint32_t current = root_;
+        while (current != kNull) {
+            auto order = threeWay(nodes_[current].value, value);
+            if (order == 0) {
+                break;
+            }
+            current = order < 0 ? right(current) : left(current);
+        }
+        return current;
+    }
+
+    // Ставит node на место old_node в родителе.
+    void replaceInParent(uint32_t old_node, uint32_t node) {
+        uint32_t pa = parent(old_node);
+        if (pa == kNull) {
+            root_ = node;
+        } else if (left(pa) == old_node) {
+            nodes_[pa].left = node;
+        } else {
+            nodes_[pa].right = node;
+        }
+        if (node != kNull) {
+            setParent(node, pa);
+        }
+    }
+
+    void rightRotation(uint32_t pivot) {
+        uint32_t node = left(pivot);
+        replaceInParent(pivot, node);
+        nodes_[pivot].left = right(node);
+        if (right(node) != kNull) {
+            setParent(right(node), pivot);
+        }
+        nodes_[node].right = pivot;
+        setParent(pivot, node);
+    }
+
+    void leftRotation(uint32_t pivot) {
+        uint32_t node = right(pivot);
+        replaceInParent(pivot, node);
+        nodes_[pivot].right = left(node);
+        if (left(node) != kNull) {
+            setParent(left(node), pivot);
+        }
+        nodes_[node].left = pivot;
+        setParent(pivot, node);
+    }
+
+    void balance(uint32_t son) {
+        while (isRed(parent(son))) {
+            uint32_t pa = parent(son);
+            uint32_t grandpa = parent(pa);
+            bool pa_is_left = left(grandpa) == pa;
+            uint32_t uncle = pa_is_left ? right(grandpa) : left(grandpa);
+            // Случай 1: дядя красный.
+            if (isRed(uncle)) {
+                setRed(pa, false);
+                setRed(uncle, false);
+                setRed(grandpa, true);
+                son = grandpa;
+                continue;
+            }
+            // Случай 2: дядя чёрный, son — внутренний внук.
+            if (pa_is_left && right(pa) == son) {
+                leftRotation(pa);
+                std::swap(pa, son);
+            } else if (!pa_is_left && left(pa) == son) {
+                rightRotation(pa);
+                std::swap(pa, son);
+            }
+            // Случай 3: son — внешний внук.
+            if (pa_is_left) {
+                rightRotation(grandpa);
+            } else {
+                leftRotation(grandpa);
+            }
+            setRed(grandpa, true);
+            setRed(pa, false);
+            break;
+        }
+        setRed(root_, false);
+    }
+
+    void eraseNode(uint32_t node) {
+        uint32_t child;
+        uint32_t pa;
+        bool removed_red = isRed(node);
+        if (left(node) == kNull || right(node) == kNull) {
+            child = left(node) != kNull ? left(node) : right(node);
+            pa = parent(node);
+            replaceInParent(node, child);
+        } else {
+            // Две дочерние вершины: место node занимает следующая за ней.
+            uint32_t next = mostLeft(right(node));
+            removed_red = isRed(next);
+            child = right(next);
+            if (parent(next) == node) {
+                pa = next;
+            } else {
+                pa = parent(next);
+                replaceInParent(next, child);
+                nodes_[next].right = right(node);
+                setParent(right(node), next);
+            }
+            replaceInParent(node, next);
+            nodes_[next].left = left(node);
+            setParent(left(node), next);
+            setRed(next, isRed(node));
+        }
+        if (!removed_red) {
+            fixErase(child, pa);
+        }
+        removeSlot(node);
+    }
+
+    // На пути через node (возможно, пустую) с родителем pa не хватает одной чёрной вершины.
+    void fixErase(uint32_t node, uint32_t pa) {
+        while (node != root_ && isBlack(node)) {
+            bool is_left = left(pa) == node;
+            uint32_t sibling = is_left ? right(pa) : left(pa);
+            // Случай 1: брат красный — поворот делает его чёрным.
+            if (isRed(sibling)) {
+                setRed(sibling, false);
+                setRed(pa, true);
+                if (is_left) {
+                    leftRotation(pa);
+                } else {
+                    rightRotation(pa);
+                }
+                sibling = is_left ? right(pa) : left(pa);
+            }
+            uint32_t near = is_left ? left(sibling) : right(sibling);
+            uint32_t far = is_left ? right(sibling) : left(sibling);
+            // Случай 2: оба ребёнка брата чёрные — недостача поднимается к родителю.
+            if (isBlack(near) && isBlack(far)) {
+                setRed(sibling, true);
+                node = pa;
+                pa = parent(node);
+                continue;
+            }
+            // Случай 3: дальний ребёнок брата чёрный — сводится к случаю 4.
+            if (isBlack(far)) {
+                setRed(near, false);
+                setRed(sibling, true);
+                if (is_left) {
+                    rightRotation(sibling);
+                } else {
+                    leftRotation(sibling);
+                }
+                far = sibling;
+                sibling = near;
+            }
+            // Случай 4: дальний ребёнок брата красный.
+            setRed(sibling, isRed(pa));
+            setRed(pa, false);
+            setRed(far, false);
+            if (is_left) {
+                leftRotation(pa);
+            } else {
+                rightRotation(pa);
+            }
+            node = root_;
+        }
+        if (node != kNull) {
+            setRed(node, false);
+        }
+    }
+
+    // Освобождает ячейку уже отцепленной вершины slot, перенося в неё последнюю вершину.
+    void removeSlot(uint32_t slot) {
+        uint32_t last = static_cast<uint32_t>(nodes_.size() - 1);
+        if (slot != last) {
+            nodes_[slot] = std::move(nodes_[last]);
+            uint32_t pa = parent(slot);
+            if (pa == kNull) {
+                root_ = slot;
+            } else if (left(pa) == last) {
+                nodes_[pa].left = slot;
+            } else {
+                nodes_[pa].right = slot;
+            }
+            if (left(slot) != kNull) {
+                setParent(left(slot), slot);
+            }
+            if (right(slot) != kNull) {
+                setParent(right(slot), slot);
+            }
+        }
+        nodes_.pop_back();
+    }
+};
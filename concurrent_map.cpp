@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <vector>
+
+#include "map.cpp"
+
+// Потокобезопасный упорядоченный словарь: ключи разбиты на диапазоны по границам
+// boundaries, каждый диапазон хранится в своём Map под своим reader-writer мьютексом.
+// Точечные операции блокируют только один шард, поэтому масштабируются по ядрам.
+template <typename K, typename V, typename Compare = std::less<K>>
+class ConcurrentMap {
+public:
+    // Шард i содержит ключи из [boundaries[i - 1], boundaries[i]).
+    explicit ConcurrentMap(std::vector<K> boundaries, const Compare& comp = Compare())
+        : boundaries_(std::move(boundaries)), shards_(boundaries_.size() + 1), comp_(comp) {
+        std::sort(boundaries_.begin(), boundaries_.end(), comp_);
+        for (Shard& shard : shards_) {
+            shard.map = Map<K, V, Compare>(comp_);
+        }
+    }
+
+    ConcurrentMap(const ConcurrentMap&) = delete;
+    ConcurrentMap& operator=(const ConcurrentMap&) = delete;
+
+    void insert(const K& key, const V& value) {
+        Shard& shard = shardOf(key);
+        std::unique_lock lock(shard.mutex);
+        shard.map.insert(key, value);
+    }
+
+    void erase(const K& key) {
+        Shard& shard = shardOf(key);
+        std::unique_lock lock(shard.mutex);
+        shard.map.erase(key);
+    }
+
+    std::optional<V> find(const K& key) const {
+        const Shard& shard = shardOf(key);
+        std::shared_lock lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    bool contains(const K& key) const {
+        const Shard& shard = shardOf(key);
+        std::shared_lock lock(shard.mutex);
+        return shard.map.find(key) != shard.map.end();
+    }
+
+    // Сумма размеров шардов, которые читаются по очереди.
+    size_t size() const {
+        size_t total = 0;
+        for (const Shard& shard : shards_) {
+            std::shared_lock lock(shard.mutex);
+            total += shard.map.size();
+        }
+        return total;
+    }
+
+    // Обходит ключи из [lo, hi) по возрастанию. Все затронутые шарды блокируются на чтение
+    // в порядке возрастания до начала обхода, поэтому диапазон виден согласованно.
+    template <typename Callback>
+    void forEach(const K& lo, const K& hi, Callback callback) const {
+        if (!comp_(lo, hi)) {
+            return;
+        }
+        size_t first = shardIndex(lo);
+        size_t last = shardIndex(hi);
+        std::vector<std::shared_lock<std::shared_mutex>> locks;
+        locks.reserve(last - first + 1);
+        for (size_t i = first; i <= last; ++i) {
+            locks.emplace_back(shards_[i].mutex);
+        }
+        for (size_t i = first; i <= last; ++i) {
+            const auto& map = shards_[i].map;
+            for (auto it = map.lowerBound(lo); it != map.end(); ++it) {
+                if (!comp_(it->first, hi)) {
+                    return;
+                }
+                callback(it->first, it->second);
+            }
+        }
+    }
+
+private:
+    // Выравнивание по кэш-линии убирает ложное разделение мьютексов соседних шардов.
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        Map<K, V, Compare> map;
+    };
+
+    std::vector<K> boundaries_;
+    std::vector<Shard> shards_;
+    Compare comp_;
+
+    size_t shardIndex(const K& key) const {
+        return std::upper_bound(boundaries_.begin(), boundaries_.end(), key, comp_) -
+               boundaries_.begin();
+    }
+
+    Shard& shardOf(const K& key) {
+        return shards_[shardIndex(key)];
+    }
+
+    const Shard& shardOf(const K& key) const {
+        return shards_[shardIndex(key)];
+    }
+};
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Формат файла: заголовок, затем отсортированные ключи и значения в том же порядке.
+// Ключи лежат отдельно от значений, чтобы двоичный поиск читал только их.
+struct FrozenMapHeader {
+    static constexpr uint64_t kMagic = 0x3150414d4e5a5246;  // "FRZNMAP1"
+    static constexpr uint64_t kAlignment = 64;
+
+    uint64_t magic;
+    uint64_t count;
+    uint64_t key_size;
+    uint64_t value_size;
+    uint64_t keys_offset;
+    uint64_t values_offset;
+};
+
+inline uint64_t alignFrozenOffset(uint64_t offset) {
+    return (offset + FrozenMapHeader::kAlignment - 1) / FrozenMapHeader::kAlignment *
+           FrozenMapHeader::kAlignment;
+}
+
+// Выгружает упорядоченный словарь (Map, BTreeMap) в файл, который FrozenMap
+// открывает через mmap без десериализации.
+template <typename MapType>
+void freeze(const MapType& map, const std::string& path) {
+    using Entry = std::remove_reference_t<decltype(*map.begin())>;
+    using K = std::remove_cv_t<typename Entry::first_type>;
+    using V = typename Entry::second_type;
+    static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>,
+                  "freeze requires trivially copyable keys and values");
+
+    FrozenMapHeader header{};
+    header.magic = FrozenMapHeader::kMagic;
+    header.count = map.size();
+    header.key_size = sizeof(K);
+    header.value_size = sizeof(V);
+    header.keys_offset = alignFrozenOffset(sizeof(FrozenMapHeader));
+    header.values_offset = alignFrozenOffset(header.keys_offset + header.count * sizeof(K));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    auto pad = [&out](uint64_t offset) {
+        while (static_cast<uint64_t>(out.tellp()) < offset) {
+            out.put('\0');
+        }
+    };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pad(header.keys_offset);
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        out.write(reinterpret_cast<const char*>(&it->first), sizeof(K));
+    }
+    pad(header.values_offset);
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        out.write(reinterpret_cast<const char*>(&it->second), sizeof(V));
+    }
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+// Словарь только для чтения поверх отображённого в память файла, созданного freeze.
+// Открытие стоит O(1): данные подгружаются страницами по мере обращения.
+template <typename K, typename V, typename Compare = std::less<K>>
+class FrozenMap {
+    static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>,
+                  "FrozenMap requires trivially copyable keys and values");
+
+public:
+    struct Iterator {
+        using Reference = std::pair<const K&, const V&>;
+
+        // Ключ и значение хранятся раздельно, поэтому -> возвращает обёртку над парой ссылок.
+        struct Arrow {
+            Reference pair;
+            const Reference* operator->() const {
+                return &pair;
+            }
+        };
+
+        Iterator() : map_(nullptr), index_(0) {
+        }
+        Iterator(const FrozenMap* map, size_t index) : map_(map), index_(index) {
+        }
+
+        Reference operator*() const {
+            return {map_->keys_[index_], map_->values_[index_]};
+        }
+        Arrow operator->() const {
+            return {**this};
+        }
+
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator copy_it(*this);
+            ++index_;
+            return copy_it;
+        }
+        Iterator& operator--() {
+            --index_;
+            return *this;
+        }
+        Iterator operator--(int) {
+            Iterator copy_it(*this);
+            --index_;
+            return copy_it;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return map_ == other.map_ && index_ == other.index_;
+        }
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const FrozenMap* map_;
+        size_t index_;
+    };
+
+    explicit FrozenMap(const std::string& path, const Compare& comp = Compare())
+        : data_(nullptr), length_(0), keys_(nullptr), values_(nullptr), size_(0), comp_(comp) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(FrozenMapHeader)) {
+            close(fd);
+            throw std::runtime_error("Wrong frozen map file " + path);
+        }
+        length_ = info.st_size;
+        data_ = mmap(nullptr, length_, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data_ == MAP_FAILED) {
+            data_ = nullptr;
+            throw std::runtime_error("Cannot map " + path);
+        }
+
+        const auto* header = static_cast<const FrozenMapHeader*>(data_);
+        if (header->magic != FrozenMapHeader::kMagic || header->key_size != sizeof(K) ||
+            header->value_size != sizeof(V) || header->keys_offset < sizeof(FrozenMapHeader) ||
+            header->values_offset > length_ ||
+            !regionFits(header->keys_offset, header->count, alignof(K), sizeof(K),
+                        header->values_offset) ||
+            !regionFits(header->values_offset, header->count, alignof(V), sizeof(V), length_)) {
+            munmap(data_, length_);
+            throw std::runtime_error("Wrong frozen map file " + path);
+        }
+        const char* base = static_cast<const char*>(data_);
+        keys_ = reinterpret_cast<const K*>(base + header->keys_offset);
+        values_ = reinterpret_cast<const V*>(base + header->values_offset);
+        size_ = header->count;
+    }
+
+    FrozenMap(const FrozenMap&) = delete;
+    FrozenMap& operator=(const FrozenMap&) = delete;
+
+    ~FrozenMap() {
+        if (data_) {
+            munmap(data_, length_);
+        }
+    }
+
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    Iterator lowerBound(const K& key) const {
+        return Iterator(this, std::lower_bound(keys_, keys_ + size_, key, comp_) - keys_);
+    }
+
+    Iterator find(const K& key) const {
+        size_t index = std::lower_bound(keys_, keys_ + size_, key, comp_) - keys_;
+        if (index == size_ || comp_(key, keys_[index])) {
+            return end();
+        }
+        return Iterator(this, index);
+    }
+
+    Iterator begin() const {
+        return Iterator(this, 0);
+    }
+    Iterator end() const {
+        return Iterator(this, size_);
+    }
+
+private:
+    // count элементов по size байт, начиная с offset, выровнены под align и помещаются
+    // до limit. Считается без переполнения для любых значений из заголовка.
+    static bool regionFits(uint64_t offset, uint64_t count, uint64_t align, uint64_t size,
+                           uint64_t limit) {
+        if (offset % align != 0 || offset > limit) {
+            return false;
+        }
+        return count <= (limit - offset) / size;
+    }
+
+    void* data_;
+    size_t length_;
+    const K* keys_;
+    const V* values_;
+    size_t size_;
+    Compare comp_;
+};
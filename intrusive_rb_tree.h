@@ -0,0 +1,377 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include "three_way_compare.h"
+
+// Ссылки дерева, встроенные в объект пользователя. Объект с несколькими крючками
+// может одновременно находиться в нескольких деревьях.
+template <typename T>
+struct RBHook {
+    T* left;
+    T* right;
+    T* parent;
+    bool red;
+
+    RBHook() : left(nullptr), right(nullptr), parent(nullptr), red(false) {
+    }
+};
+
+// Интрузивное красно-чёрное дерево: insert и erase только связывают и отцепляют
+// уже существующие объекты, ничего не выделяя и не копируя. Дерево не владеет
+// объектами: они должны жить, пока в нём находятся, а clear() лишь забывает о них.
+// Hook — указатель на член-крючок, например &Order::by_price.
+template <typename T, RBHook<T> T::*Hook, typename Compare = std::less<T>>
+class IntrusiveRBTree {
+public:
+    struct Iterator {
+        Iterator() : current_(nullptr), tree_(nullptr) {
+        }
+        Iterator(T* node, const IntrusiveRBTree* tree) : current_(node), tree_(tree) {
+        }
+
+        T& operator*() const {
+            return *current_;
+        }
+        T* operator->() const {
+            return current_;
+        }
+
+        Iterator& operator++() {
+            if (!current_) {
+                current_ = mostLeft(tree_->root_);
+            } else if (hook(current_).right) {
+                current_ = mostLeft(hook(current_).right);
+            } else {
+                T* pa = hook(current_).parent;
+                while (pa && hook(pa).right == current_) {
+                    current_ = pa;
+                    pa = hook(pa).parent;
+                }
+                current_ = pa;
+            }
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator copy_it(*this);
+            ++(*this);
+            return copy_it;
+        }
+
+        Iterator& operator--() {
+            if (!current_) {
+                current_ = mostRight(tree_->root_);
+            } else if (hook(current_).left) {
+                current_ = mostRight(hook(current_).left);
+            } else {
+                T* pa = hook(current_).parent;
+                while (pa && hook(pa).left == current_) {
+                    current_ = pa;
+                    pa = hook(pa).parent;
+                }
+                current_ = pa;
+            }
+            return *this;
+        }
+        Iterator operator--(int) {
+            Iterator copy_it(*this);
+            --(*this);
+            return copy_it;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return current_ == other.current_;
+        }
+        bool operator!=(const Iterator& other) const {
+            return current_ != other.current_;
+        }
+
+    private:
+        T* current_;
+        const IntrusiveRBTree* tree_;
+    };
+
+    IntrusiveRBTree() : root_(nullptr), size_(0) {
+    }
+    explicit IntrusiveRBTree(const Compare& comp) : root_(nullptr), size_(0), comp_(comp) {
+    }
+
+    IntrusiveRBTree(const IntrusiveRBTree&) = delete;
+    IntrusiveRBTree& operator=(const IntrusiveRBTree&) = delete;
+
+    void clear() {
+        root_ = nullptr;
+        size_ = 0;
+    }
+
+    // Связывает obj с деревом. Если равный объект уже есть, obj не трогается
+    // и возвращается false.
+    bool insert(T& obj) {
+        T* pa = nullptr;
+        T* current = root_;
+        bool to_right = false;
+        while (current) {
+            auto order = threeWay(comp_, *current, obj);
+            if (order == 0) {
+                return false;
+            }
+            pa = current;
+            to_right = order < 0;
+            current = to_right ? hook(current).right : hook(current).left;
+        }
+        T* node = &obj;
+        hook(node).left = nullptr;
+        hook(node).right = nullptr;
+        hook(node).parent = pa;
+        hook(node).red = true;
+        if (!pa) {
+            root_ = node;
+        } else if (to_right) {
+            hook(pa).right = node;
+        } else {
+            hook(pa).left = node;
+        }
+        balance(node);
+        ++size_;
+        return true;
+    }
+
+    // Отцепляет obj, который должен находиться в этом дереве; поиск не нужен.
+    void erase(T& obj) {
+        eraseNode(&obj);
+    }
+
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    template <typename KeyLike>
+    Iterator lowerBound(const KeyLike& key) const {
+        T* res = nullptr;
+        T* current = root_;
+        while (current) {
+            if (lessThan(comp_, *current, key)) {
+                current = hook(current).right;
+            } else {
+                res = current;
+                current = hook(current).left;
+            }
+        }
+        return Iterator(res, this);
+    }
+
+    template <typename KeyLike>
+    Iterator find(const KeyLike& key) const {
+        T* current = root_;
+        while (current) {
+            auto order = threeWay(comp_, *current, key);
+            if (order == 0) {
+                break;
+            }
+            current = order < 0 ? hook(current).right : hook(current).left;
+        }
+        return Iterator(current, this);
+    }
+
+    Iterator begin() const {
+        return Iterator(mostLeft(root_), this);
+    }
+    Iterator end() const {
+        return Iterator(nullptr, this);
+    }
+
+private:
+    T* root_;
+    size_t size_;
+    Compare comp_;
+
+    static RBHook<T>& hook(T* node) {
+        return node->*Hook;
+    }
+
+    static bool isBlack(T* node) {
+        return !node || !hook(node).red;
+    }
+
+    static T* mostLeft(T* node) {
+        if (!node) {
+            return nullptr;
+        }
+        while (hook(node).left) {
+            node = hook(node).left;
+        }
+        return node;
+    }
+
+    static T* mostRight(T* node) {
+        if (!node) {
+            return nullptr;
+        }
+        while (hook(node).right) {
+            node = hook(node).right;
+        }
+        return node;
+    }
+
+    void replaceInParent(T* old_node, T* node) {
+        T* pa = hook(old_node).parent;
+        if (!pa) {
+            root_ = node;
+        } else if (hook(pa).left == old_node) {
+            hook(pa).left = node;
+        } else {
+            hook(pa).right = node;
+        }
+        if (node) {
+            hook(node).parent = pa;
+        }
+    }
+
+    void rightRotation(T* pivot) {
+        T* node = hook(pivot).left;
+        replaceInParent(pivot, node);
+        hook(pivot).left = hook(node).right;
+        if (hook(node).right) {
+            hook(hook(node).right).parent = pivot;
+        }
+        hook(node).right = pivot;
+        hook(pivot).parent = node;
+    }
+
+    void leftRotation(T* pivot) {
+        T* node = hook(pivot).right;
+        replaceInParent(pivot, node);
+        hook(pivot).right = hook(node).left;
+        if (hook(node).left) {
+            hook(hook(node).left).parent = pivot;
+        }
+        hook(node).left = pivot;
+        hook(pivot).parent = node;
+    }
+
+    void balance(T* son) {
+        while (!isBlack(hook(son).parent)) {
+            T* pa = hook(son).parent;
+            T* grandpa = hook(pa).parent;
+            bool pa_is_left = hook(grandpa).left == pa;
+            T* uncle = pa_is_left ? hook(grandpa).right : hook(grandpa).left;
+            // Случай 1: дядя красный.
+            if (!isBlack(uncle)) {
+                hook(pa).red = false;
+                hook(uncle).red = false;
+                hook(grandpa).red = true;
+                son = grandpa;
+                continue;
+            }
+            // Случай 2: дядя чёрный, son — внутренний внук.
+            if (pa_is_left && hook(pa).right == son) {
+                leftRotation(pa);
+                std::swap(pa, son);
+            } else if (!pa_is_left && hook(pa).left == son) {
+                rightRotation(pa);
+                std::swap(pa, son);
+            }
+            // Случай 3: son — внешний внук.
+            if (pa_is_left) {
+                rightRotation(grandpa);
+            } else {
+                leftRotation(grandpa);
+            }
+            hook(grandpa).red = true;
+            hook(pa).red = false;
+            break;
+        }
+        hook(root_).red = false;
+    }
+
+    void eraseNode(T* node) {
+        T* child;
+        T* pa;
+        bool removed_red = hook(node).red;
+        if (!hook(node).left || !hook(node).right) {
+            child = hook(node).left ? hook(node).left : hook(node).right;
+            pa = hook(node).parent;
+            replaceInParent(node, child);
+        } else {
+            // Две дочерние вершины: место node занимает следующая за ней.
+            T* next = mostLeft(hook(node).right);
+            removed_red = hook(next).red;
+            child = hook(next).right;
+            if (hook(next).parent == node) {
+                pa = next;
+            } else {
+                pa = hook(next).parent;
+                replaceInParent(next, child);
+                hook(next).right = hook(node).right;
+                hook(hook(next).right).parent = next;
+            }
+            replaceInParent(node, next);
+            hook(next).left = hook(node).left;
+            hook(hook(next).left).parent = next;
+            hook(next).red = hook(node).red;
+        }
+        if (!removed_red) {
+            fixErase(child, pa);
+        }
+        hook(node) = RBHook<T>();
+        --size_;
+    }
+
+    // На пути через node (возможно, пустую) с родителем pa не хватает одной чёрной вершины.
+    void fixErase(T* node, T* pa) {
+        while (node != root_ && isBlack(node)) {
+            bool is_left = hook(pa).left == node;
+            T* sibling = is_left ? hook(pa).right : hook(pa).left;
+            // Случай 1: брат красный — поворот делает его чёрным.
+            if (hook(sibling).red) {
+                hook(sibling).red = false;
+                hook(pa).red = true;
+                if (is_left) {
+                    leftRotation(pa);
+                } else {
+                    rightRotation(pa);
+                }
+                sibling = is_left ? hook(pa).right : hook(pa).left;
+            }
+            T* near = is_left ? hook(sibling).left : hook(sibling).right;
+            T* far = is_left ? hook(sibling).right : hook(sibling).left;
+            // Случай 2: оба ребёнка брата чёрные — недостача поднимается к родителю.
+            if (isBlack(near) && isBlack(far)) {
+                hook(sibling).red = true;
+                node = pa;
+                pa = hook(node).parent;
+                continue;
+            }
+            // Случай 3: дальний ребёнок брата чёрный — сводится к случаю 4.
+            if (isBlack(far)) {
+                hook(near).red = false;
+                hook(sibling).red = true;
+                if (is_left) {
+                    rightRotation(sibling);
+                } else {
+                    leftRotation(sibling);
+                }
+                far = sibling;
+                sibling = near;
+            }
+            // Случай 4: дальний ребёнок брата красный.
+            hook(sibling).red = hook(pa).red;
+            hook(pa).red = false;
+            hook(far).red = false;
+            if (is_left) {
+                leftRotation(pa);
+            } else {
+                rightRotation(pa);
+            }
+            node = root_;
+        }
+        if (node) {
+            hook(node).red = false;
+        }
+    }
+};
@@ -1,39 +1,50 @@
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <stdexcept>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
-enum Color { RED, BLACK };
+#include "slab_allocator.h"
+#include "three_way_compare.h"
+#include "tree_stats.h"
 
-template <typename ValueType>
-constexpr bool operator==(const ValueType& first, const ValueType& second) {
-    return !(first < second) && !(second < first);
-}
+enum Color { RED, BLACK };
 
 template <typename K, typename V>
 struct Node {
-    K key;
-    V value;
+    std::pair<const K, V> data;
     Node<K, V>* left;
     Node<K, V>* right;
     Node<K, V>* parent;
     Color color;
 
-    Node() : key(), value(), left(nullptr), right(nullptr), parent(nullptr), color(Color::RED) {
+    Node() : data(), left(nullptr), right(nullptr), parent(nullptr), color(Color::RED) {
     }
     explicit Node(const K& key, const V& value)
-        : key(key),
-          value(value),
+        : data(key, value), left(nullptr), right(nullptr), parent(nullptr), color(Color::RED) {
+    }
+    Node(const K& key, const V& value, Node<K, V>* pa)
+        : data(key, value), left(nullptr), right(nullptr), parent(pa), color(Color::RED) {
+    }
+    template <typename... Args>
+    explicit Node(std::in_place_t, Args&&... args)
+        : data(std::forward<Args>(args)...),
           left(nullptr),
           right(nullptr),
           parent(nullptr),
           color(Color::RED) {
     }
-    Node(K key, V value, Node<K, V>* pa)
-        : key(key), value(value), left(nullptr), right(nullptr), parent(pa), color(Color::RED) {
-    }
 };
 
-template <typename K, typename V>
+// Compare может быть прозрачным (например, std::less<>): тогда find, lowerBound и erase
+// принимают любой сравнимый с K тип без построения ключа.
+template <typename K, typename V, typename Compare = std::less<K>,
+          typename Allocator = SlabAllocator<Node<K, V>>>
 class Map {
 public:
     struct Iterator {
@@ -44,17 +55,14 @@ public:
         Iterator(const Node<K, V>* node, const Node<K, V>* root) : current_(node), root_(root) {
         }
 
-        const std::pair<K, V>& operator*() const {
-            if (!current_) {
-                return *new std::pair<K, V>({}, {});
-            }
-            return *new std::pair<K, V>(current_->key, current_->value);
+        const std::pair<const K, V>& operator*() const {
+            return current_->data;
         }
-        const std::pair<K, V>* operator->() const {
+        const std::pair<const K, V>* operator->() const {
             if (!current_) {
                 return nullptr;
             }
-            return new std::pair<K, V>(current_->key, current_->value);
+            return &current_->data;
         }
 
         Iterator& operator++() {
@@ -170,113 +178,249 @@ public:
         const Node<K, V>* root_;
     };
 
-    Map() : root(nullptr), size_(0) {
+    Map() : root(nullptr), size_(0), rightmost_(nullptr) {
+    }
+    explicit Map(const Compare& comp) : root(nullptr), size_(0), rightmost_(nullptr), comp_(comp) {
     }
-    Map(std::initializer_list<std::pair<K, V>> list) {
+    Map(std::initializer_list<std::pair<K, V>> list) : Map() {
         for (auto [key, val] : list) {
             insert(key, val);
         }
     }
-    Map(const Map& other) {
-        if (!other.root) {
-            root = nullptr;
-            size_ = 0;
-            return;
-        }
-        root = new Node<K, V>(other.root->key, other.root->value);
-        root->color = Color::BLACK;
-        size_ = other.size_;
-        copyChildren(root, other.root);
+    Map(const Map& other) : Map(other.comp_) {
+        copyFrom(other);
+    }
+    Map(Map&& other) noexcept
+        : root(other.root),
+          size_(other.size_),
+          rightmost_(other.rightmost_),
+          comp_(std::move(other.comp_)),
+          alloc_(std::move(other.alloc_)) {
+        other.root = nullptr;
+        other.size_ = 0;
+        other.rightmost_ = nullptr;
     }
 
-    Map<K, V>& operator=(const Map& other) {
-        if (!other.root) {
-            root = nullptr;
-            size_ = 0;
-            return *this;
+    Map& operator=(const Map& other) {
+        if (this != &other) {
+            clear();
+            comp_ = other.comp_;
+            copyFrom(other);
         }
-        root = new Node<K, V>(other.root->key, other.root->value);
-        root->color = Color::BLACK;
-        size_ = other.size_;
-        copyChildren(root, other.root);
+        return *this;
+    }
+
+    Map& operator=(Map&& other) noexcept {
+        std::swap(root, other.root);
+        std::swap(size_, other.size_);
+        std::swap(rightmost_, other.rightmost_);
+        std::swap(comp_, other.comp_);
+        std::swap(alloc_, other.alloc_);
         return *this;
     }
 
     ~Map() {
-        deleteNode(root);
+        clear();
     }
 
-    void insert(const K& key, const V& value) {
-        if (!root) {
-            root = new Node<K, V>(key, value);
-            root->color = Color::BLACK;
-            ++size_;
-            return;
+    void clear() {
+        // Память вершин отдаётся аллокатору целиком, обход нужен только ради деструкторов.
+        // После split блоки общие с другими словарями, и вершины возвращаются по одной.
+        if (!std::is_trivially_destructible_v<Node<K, V>> || alloc_.isShared()) {
+            destroyNodes(root);
         }
-        Node<K, V>* current = root;
-        insertNode(current, key, value);
+        alloc_.release();
+        root = nullptr;
+        size_ = 0;
+        rightmost_ = nullptr;
     }
 
-    void erase(const K& key) {
-        Node<K, V>* to_del = findNode(key);
-        if (!to_del) {
-            return;
+    // Строит дерево за O(n) по диапазону пар, отсортированному по возрастанию ключей без повторов.
+    // Дерево получается почти полным: вершины неполного нижнего уровня красные, остальные чёрные.
+    template <typename Iter>
+    void assignSorted(Iter begin, Iter end) {
+        clear();
+        size_t count = std::distance(begin, end);
+        size_t full_levels = 0;
+        while ((size_t(2) << full_levels) - 1 <= count) {
+            ++full_levels;
         }
+        root = buildSorted(begin, count, 0, full_levels, nullptr);
+        size_ = count;
+        rightmost_ = Iterator::mostRight(root);
+    }
 
-        // Это лист.
-        if (!to_del->right && !to_del->left) {
-            delLeaf(to_del);
-            // Вершина с двумя потомками.
-        } else if (to_del->right && to_del->left) {
-            Node<K, V>* ios = Iterator::mostRight(to_del->left);
-            std::swap(ios->key, to_del->key);
-            std::swap(ios->value, to_del->value);
-            if (ios->right || ios->left) {
-                delOnlyChild(ios);
-            } else {
-                delLeaf(ios);
+    void insert(const K& key, const V& value) {
+        insertOrAssign(key, value);
+    }
+
+    // Вставка с подсказкой: hint указывает на элемент, перед которым должен оказаться key.
+    // При верной подсказке вставка в конец (hint == end()) обходится без спуска по дереву.
+    template <typename KeyArg, typename ValueArg>
+    Iterator insert(Iterator hint, KeyArg&& key, ValueArg&& value) {
+        const K& key_ref = key;
+        Node<K, V>* next = const_cast<Node<K, V>*>(hint.current_);
+        Node<K, V>* prev = rightmost_;
+        if (next) {
+            Iterator it(next, root);
+            prev = const_cast<Node<K, V>*>((--it).current_);
+            if (equal(key_ref, next->data.first)) {
+                next->data.second = std::forward<ValueArg>(value);
+                return Iterator(next, root);
             }
-            // Чёрная вершина с одним потомком.
+        }
+        if (prev && equal(key_ref, prev->data.first)) {
+            prev->data.second = std::forward<ValueArg>(value);
+            return Iterator(prev, root);
+        }
+        if ((prev && !keyLess(prev->data.first, key_ref)) ||
+            (next && !keyLess(key_ref, next->data.first))) {
+            return insertOrAssign(std::forward<KeyArg>(key), std::forward<ValueArg>(value)).first;
+        }
+        Node<K, V>* node = alloc_.create(std::in_place, std::forward<KeyArg>(key),
+                                         std::forward<ValueArg>(value));
+        if (next && !next->left) {
+            linkNode(node, next, &next->left);
+        } else if (prev) {
+            linkNode(node, prev, &prev->right);
         } else {
-            // Только один ребёнок.
-            delOnlyChild(to_del);
+            linkNode(node, nullptr, &root);
         }
-        --size_;
+        return Iterator(node, root);
     }
 
-    void delOnlyChild(Node<K, V>* to_del) {
-        // Только правый ребёнок.
-        if (to_del->right) {
-            std::swap(to_del->key, to_del->right->key);
-            std::swap(to_del->value, to_del->right->value);
-            delLeaf(to_del->right);
-            // Только левый ребёнок.
-        } else {
-            std::swap(to_del->key, to_del->left->key);
-            std::swap(to_del->value, to_del->left->value);
-            delLeaf(to_del->left);
+    template <typename... Args>
+    std::pair<Iterator, bool> emplace(Args&&... args) {
+        Node<K, V>* node = alloc_.create(std::in_place, std::forward<Args>(args)...);
+        Node<K, V>* pa;
+        Node<K, V>** link = findLink(node->data.first, pa);
+        if (*link) {
+            alloc_.destroy(node);
+            return {Iterator(*link, root), false};
         }
+        linkNode(node, pa, link);
+        return {Iterator(node, root), true};
+    }
+
+    // Если ключ уже есть, аргументы не трогаются и значение не создаётся.
+    template <typename KeyArg, typename... Args>
+    std::pair<Iterator, bool> tryEmplace(KeyArg&& key, Args&&... args) {
+        Node<K, V>* pa;
+        Node<K, V>** link = findLink(key, pa);
+        if (*link) {
+            return {Iterator(*link, root), false};
+        }
+        Node<K, V>* node = alloc_.create(std::in_place, std::piecewise_construct,
+                                         std::forward_as_tuple(std::forward<KeyArg>(key)),
+                                         std::forward_as_tuple(std::forward<Args>(args)...));
+        linkNode(node, pa, link);
+        return {Iterator(node, root), true};
+    }
+
+    template <typename KeyArg, typename ValueArg>
+    std::pair<Iterator, bool> insertOrAssign(KeyArg&& key, ValueArg&& value) {
+        Node<K, V>* pa;
+        Node<K, V>** link = findLink(key, pa);
+        if (*link) {
+            (*link)->data.second = std::forward<ValueArg>(value);
+            return {Iterator(*link, root), false};
+        }
+        Node<K, V>* node = alloc_.create(std::in_place, std::forward<KeyArg>(key),
+                                         std::forward<ValueArg>(value));
+        linkNode(node, pa, link);
+        return {Iterator(node, root), true};
+    }
+
+    void erase(const K& key) {
+        eraseNode(findNode(key));
+    }
+
+    template <typename KeyLike, typename C = Compare, typename = typename C::is_transparent>
+    void erase(const KeyLike& key) {
+        eraseNode(findNode(key));
+    }
+
+    void delOnlyChild(Node<K, V>* to_del) {
+        // Единственный ребёнок обязательно красный лист.
+        Node<K, V>* child = to_del->right ? to_del->right : to_del->left;
+        replaceInParent(to_del, child);
+        recolor(child, Color::BLACK);
     }
 
+    // O(1), пока размер известен. После split размеры частей не известны, и size() обходит
+    // дерево за O(n) при каждом вызове, ничего не записывая; countSize() запоминает результат.
     size_t size() const {
+        return size_ != kUnknownSize ? size_ : countNodes();
+    }
+    size_t countSize() {
+        if (size_ == kUnknownSize) {
+            size_ = countNodes();
+        }
         return size_;
     }
     bool empty() const {
-        return size_ == 0;
+        return !root;
+    }
+
+    // Оставляет в словаре ключи меньше key, а остальные переносит в результат за O(log n).
+    // Размеры частей остаются неизвестными (см. size()), пока часть не опустеет.
+    Map split(const K& key) {
+        Map res(comp_);
+        res.alloc_ = alloc_.sibling();
+        auto [left, right] = splitTree({root, blackHeight(root)}, key);
+        root = left.root;
+        res.root = right.root;
+        size_ = root ? kUnknownSize : 0;
+        res.size_ = res.root ? kUnknownSize : 0;
+        rightmost_ = Iterator::mostRight(root);
+        res.rightmost_ = Iterator::mostRight(res.root);
+        return res;
+    }
+
+    // Присоединяет за O(log n) словарь, все ключи которого больше (или все меньше) ключей этого.
+    void join(Map&& other) {
+        if (!other.root) {
+            return;
+        }
+        if (root && !keyLess(rightmost_->data.first, Iterator::mostLeft(other.root)->data.first) &&
+            !keyLess(other.rightmost_->data.first, Iterator::mostLeft(root)->data.first)) {
+            throw std::runtime_error("Key ranges of joined maps overlap");
+        }
+        bool other_is_right = !root || keyLess(rightmost_->data.first, other.rightmost_->data.first);
+        Map& right = other_is_right ? other : *this;
+        Node<K, V>* mid = Iterator::mostLeft(right.root);
+        right.unlinkNode(mid);
+        Subtree left_tree = other_is_right ? Subtree{root, blackHeight(root)}
+                                           : Subtree{other.root, blackHeight(other.root)};
+        Subtree right_tree = {right.root, blackHeight(right.root)};
+
+        size_t total = size_ == kUnknownSize || other.size_ == kUnknownSize
+                           ? kUnknownSize
+                           : size_ + other.size_ + 1;
+        root = joinTrees(left_tree, mid, right_tree).root;
+        size_ = total;
+        rightmost_ = Iterator::mostRight(root);
+        alloc_.adopt(std::move(other.alloc_));
+        other.root = nullptr;
+        other.size_ = 0;
+        other.rightmost_ = nullptr;
     }
 
     Iterator lowerBound(const K& key) const {
-        Node<K, V>* current = root;
-        Node<K, V>* res = nullptr;
-        res = lowerBound(key, current, res);
-        return Iterator(res, root);
+        return Iterator(lowerBound(key, root, nullptr), root);
     }
 
-    Node<K, V>* lowerBound(const K& key, Node<K, V>* current, Node<K, V>* res) const {
+    template <typename KeyLike, typename C = Compare, typename = typename C::is_transparent>
+    Iterator lowerBound(const KeyLike& key) const {
+        return Iterator(lowerBound(key, root, nullptr), root);
+    }
+
+    template <typename KeyLike>
+    Node<K, V>* lowerBound(const KeyLike& key, Node<K, V>* current, Node<K, V>* res) const {
         if (current == nullptr) {
             return res;
         }
-        if (current->key < key) {
+        if (keyLess(current->data.first, key)) {
             res = lowerBound(key, current->right, res);
         } else {
             res = lowerBound(key, current->left, current);
@@ -288,6 +432,58 @@ public:
         return Iterator(findNode(key), root);
     }
 
+    template <typename KeyLike, typename C = Compare, typename = typename C::is_transparent>
+    Iterator find(const KeyLike& key) const {
+        return Iterator(findNode(key), root);
+    }
+
+    // Пакетный поиск: спуски для разных ключей идут вперемешку, а следующая вершина
+    // каждого спуска подгружается в кэш, пока обрабатываются остальные ключи.
+    // out должен вмещать keys.size() итераторов, иначе бросается std::invalid_argument.
+    void findMany(std::span<const K> keys, std::span<Iterator> out) const {
+        if (out.size() < keys.size()) {
+            throw std::invalid_argument("Map::findMany: output is too short");
+        }
+        descendMany<false>(keys, out);
+    }
+
+    void lowerBoundMany(std::span<const K> keys, std::span<Iterator> out) const {
+        if (out.size() < keys.size()) {
+            throw std::invalid_argument("Map::lowerBoundMany: output is too short");
+        }
+        descendMany<true>(keys, out);
+    }
+
+    // Форма дерева обходом за O(n) и счётчики операций (см. TREE_STATS в tree_stats.h).
+    TreeStats stats() const {
+        TreeStats res;
+        collectShape(root, res);
+        res.black_height = blackHeight(root);
+        res.bytes_used = sizeof(*this) + res.node_count * sizeof(Node<K, V>);
+        counters_.fill(res);
+        return res;
+    }
+
+    void resetStats() {
+        counters_.reset();
+    }
+
+    // Проверяет порядок ключей, ссылки на родителей, цвета, чёрные высоты, rightmost_
+    // и размер. Стоит O(n); при нарушении бросает std::logic_error.
+    void audit() const {
+        if (root && (root->parent || root->color != Color::BLACK)) {
+            throw std::logic_error("Map audit: root must be black and have no parent");
+        }
+        size_t count = 0;
+        auditNode(root, nullptr, nullptr, nullptr, count);
+        if (size_ != kUnknownSize && size_ != count) {
+            throw std::logic_error("Map audit: size mismatch");
+        }
+        if (rightmost_ != Iterator::mostRight(root)) {
+            throw std::logic_error("Map audit: stale rightmost node");
+        }
+    }
+
     Iterator begin() const {
         return Iterator(Iterator::mostLeft(root), root);
     }
@@ -298,44 +494,257 @@ public:
     Node<K, V>* root;
 
 private:
+    // Отцепленное поддерево с чёрным корнем и его чёрная высота.
+    struct Subtree {
+        Node<K, V>* root;
+        size_t height;
+    };
+
+    static constexpr size_t kUnknownSize = static_cast<size_t>(-1);
+
+    // kUnknownSize после split, пока размер не пересчитан.
     size_t size_;
+    Node<K, V>* rightmost_;
+    Compare comp_;
 
-    void deleteNode(Node<K, V>* node) {
+    Allocator alloc_;
+    TreeCounters counters_;
+
+    void destroyNodes(Node<K, V>* node) {
         if (!node) {
             return;
         }
-        deleteNode(node->left);
-        deleteNode(node->right);
-        delete node;
+        destroyNodes(node->left);
+        destroyNodes(node->right);
+        alloc_.destroy(node);
     }
 
-    void insertNode(Node<K, V>* current, K key, V value) {
-        if (!current || key == current->key) {
-            current->value = value;
+    size_t countNodes() const {
+        size_t count = 0;
+        for (Iterator it = begin(); it.current_; ++it) {
+            ++count;
+        }
+        return count;
+    }
+
+    void copyFrom(const Map& other) {
+        if (!other.root) {
             return;
         }
-        if (current->key < key) {
-            if (current->right) {
-                insertNode(current->right, key, value);
-            } else {
-                Node<K, V>* new_node = new Node<K, V>(key, value, current);
-                current->right = new_node;
-                balance(new_node);
-                ++size_;
+        root = alloc_.create(other.root->data.first, other.root->data.second);
+        root->color = Color::BLACK;
+        size_ = other.size_;
+        copyChildren(root, other.root);
+        rightmost_ = Iterator::mostRight(root);
+    }
+
+    template <typename Iter>
+    Node<K, V>* buildSorted(Iter& it, size_t count, size_t depth, size_t red_depth,
+                            Node<K, V>* pa) {
+        if (count == 0) {
+            return nullptr;
+        }
+        size_t left_count = (count - 1) / 2;
+        Node<K, V>* left = buildSorted(it, left_count, depth + 1, red_depth, nullptr);
+        Node<K, V>* node = alloc_.create((*it).first, (*it).second, pa);
+        ++it;
+        node->color = depth < red_depth ? Color::BLACK : Color::RED;
+        node->left = left;
+        if (left) {
+            left->parent = node;
+        }
+        node->right = buildSorted(it, count - 1 - left_count, depth + 1, red_depth, node);
+        return node;
+    }
+
+    // Возвращает ссылку на место ключа в дереве: занятую, если ключ уже есть.
+    Node<K, V>** findLink(const K& key, Node<K, V>*& pa) {
+        Node<K, V>** link = &root;
+        pa = nullptr;
+        while (*link) {
+            auto order = compareKeys((*link)->data.first, key);
+            if (order == 0) {
+                break;
             }
+            pa = *link;
+            link = order < 0 ? &pa->right : &pa->left;
+        }
+        return link;
+    }
+
+    void eraseNode(Node<K, V>* to_del) {
+        if (!to_del) {
+            return;
+        }
+        unlinkNode(to_del);
+        alloc_.destroy(to_del);
+    }
+
+    // Исключает вершину из дерева, не освобождая её.
+    void unlinkNode(Node<K, V>* to_del) {
+        bool was_rightmost = to_del == rightmost_;
+
+        // Вершина с двумя потомками: ключ константный, поэтому переставляем саму вершину.
+        if (to_del->right && to_del->left) {
+            swapWithPredecessor(to_del, Iterator::mostRight(to_del->left));
+        }
+        // Это лист.
+        if (!to_del->right && !to_del->left) {
+            delLeaf(to_del);
+            // Чёрная вершина с одним потомком.
         } else {
-            if (current->left) {
-                insertNode(current->left, key, value);
+            delOnlyChild(to_del);
+        }
+        if (size_ != kUnknownSize) {
+            --size_;
+        }
+        if (was_rightmost) {
+            rightmost_ = Iterator::mostRight(root);
+        }
+    }
+
+    void linkNode(Node<K, V>* node, Node<K, V>* pa, Node<K, V>** link) {
+        node->parent = pa;
+        *link = node;
+        if (!pa || (pa == rightmost_ && link == &pa->right)) {
+            rightmost_ = node;
+        }
+        balance(node);
+        if (size_ != kUnknownSize) {
+            ++size_;
+        }
+    }
+
+    static size_t blackHeight(const Node<K, V>* node) {
+        size_t height = 0;
+        for (; node; node = node->left) {
+            if (node->color == Color::BLACK) {
+                ++height;
+            }
+        }
+        return height;
+    }
+
+    static Subtree detach(Node<K, V>* node, size_t height) {
+        if (!node) {
+            return {nullptr, 0};
+        }
+        node->parent = nullptr;
+        if (node->color == Color::RED) {
+            node->color = Color::BLACK;
+            ++height;
+        }
+        return {node, height};
+    }
+
+    std::pair<Subtree, Subtree> splitTree(Subtree tree, const K& key) {
+        Node<K, V>* node = tree.root;
+        if (!node) {
+            return {{nullptr, 0}, {nullptr, 0}};
+        }
+        Subtree left = detach(node->left, tree.height - 1);
+        Subtree right = detach(node->right, tree.height - 1);
+        if (keyLess(node->data.first, key)) {
+            auto [less, rest] = splitTree(right, key);
+            return {joinTrees(left, node, less), rest};
+        }
+        auto [less, rest] = splitTree(left, key);
+        return {less, joinTrees(rest, node, right)};
+    }
+
+    // Склеивает деревья left < mid < right: mid подвешивается на правый (левый) край
+    // более высокого дерева на уровне с чёрной высотой низкого, затем как при вставке
+    // устраняется красно-красный конфликт. Поле root используется как рабочее.
+    Subtree joinTrees(Subtree left, Node<K, V>* mid, Subtree right) {
+        mid->parent = nullptr;
+        if (left.height == right.height) {
+            mid->left = left.root;
+            mid->right = right.root;
+            if (left.root) {
+                left.root->parent = mid;
+            }
+            if (right.root) {
+                right.root->parent = mid;
+            }
+            mid->color = Color::BLACK;
+            return {mid, left.height + 1};
+        }
+
+        bool left_is_higher = left.height > right.height;
+        Subtree high = left_is_higher ? left : right;
+        size_t target = left_is_higher ? right.height : left.height;
+        Node<K, V>* pa = nullptr;
+        Node<K, V>* current = high.root;
+        size_t height = high.height;
+        while (current && !(current->color == Color::BLACK && height == target)) {
+            if (current->color == Color::BLACK) {
+                --height;
+            }
+            pa = current;
+            current = left_is_higher ? current->right : current->left;
+        }
+
+        Node<K, V>* low = left_is_higher ? right.root : left.root;
+        mid->left = left_is_higher ? current : low;
+        mid->right = left_is_higher ? low : current;
+        if (current) {
+            current->parent = mid;
+        }
+        if (low) {
+            low->parent = mid;
+        }
+        mid->parent = pa;
+        if (left_is_higher) {
+            pa->right = mid;
+        } else {
+            pa->left = mid;
+        }
+        mid->color = Color::RED;
+        root = high.root;
+        bool grew = balance(mid);
+        return {root, high.height + (grew ? 1 : 0)};
+    }
+
+    void replaceInParent(Node<K, V>* old_node, Node<K, V>* node) {
+        if (old_node->parent) {
+            if (old_node->parent->right == old_node) {
+                old_node->parent->right = node;
             } else {
-                Node<K, V>* new_node = new Node<K, V>(key, value, current);
-                current->left = new_node;
-                balance(new_node);
-                ++size_;
+                old_node->parent->left = node;
             }
+        } else {
+            root = node;
+        }
+        if (node) {
+            node->parent = old_node->parent;
+        }
+    }
+
+    void swapWithPredecessor(Node<K, V>* node, Node<K, V>* pred) {
+        Node<K, V>* pred_pa = pred->parent;
+        Node<K, V>* pred_left = pred->left;
+        std::swap(node->color, pred->color);
+        replaceInParent(node, pred);
+        pred->right = node->right;
+        pred->right->parent = pred;
+        if (pred_pa == node) {
+            pred->left = node;
+            node->parent = pred;
+        } else {
+            pred->left = node->left;
+            pred->left->parent = pred;
+            pred_pa->right = node;
+            node->parent = pred_pa;
         }
+        node->left = pred_left;
+        if (pred_left) {
+            pred_left->parent = node;
+        }
+        node->right = nullptr;
     }
 
     void rightRotation(Node<K, V>* pivot) {
+        counters_.addRotation();
         Node<K, V>* node = pivot->left;
         if (pivot->parent) {
             if (pivot->parent->right == pivot) {
@@ -357,6 +766,7 @@ private:
     }
 
     void leftRotation(Node<K, V>* pivot) {
+        counters_.addRotation();
         Node<K, V>* node = pivot->right;
         if (pivot->parent) {
             if (pivot->parent->right == pivot) {
@@ -377,18 +787,20 @@ private:
         node->left = pivot;
     }
 
-    void balance(Node<K, V>* son) {
+    // Возвращает true, если перекрашивание корня увеличило чёрную высоту дерева.
+    bool balance(Node<K, V>* son) {
         // Случай 3: корень красный.
         if (son == root) {
-            son->color = Color::BLACK;
-            return;
+            bool grew = son->color == Color::RED;
+            recolor(son, Color::BLACK);
+            return grew;
         }
         if (son->parent == root) {
-            son->parent->color = Color::BLACK;
-            return;
+            recolor(son->parent, Color::BLACK);
+            return false;
         }
         if (son->color == Color::BLACK || son->parent->color == Color::BLACK) {
-            return;
+            return false;
         }
 
         Node<K, V>* pa = son->parent;
@@ -397,10 +809,10 @@ private:
 
         // Случай 1 (и 2): дядя красный.
         if (uncle && uncle->color == Color::RED) {
-            pa->color = Color::BLACK;
-            uncle->color = Color::BLACK;
-            grandpa->color = Color::RED;
-            balance(grandpa);
+            recolor(pa, Color::BLACK);
+            recolor(uncle, Color::BLACK);
+            recolor(grandpa, Color::RED);
+            return balance(grandpa);
         } else {
             // Случай 4 (и 5): дядя чёрный или его нет.
             if (grandpa->left == pa) {
@@ -416,9 +828,10 @@ private:
                 }
                 leftRotation(grandpa);
             }
-            grandpa->color = Color::RED;
-            pa->color = Color::BLACK;
+            recolor(grandpa, Color::RED);
+            recolor(pa, Color::BLACK);
         }
+        return false;
     }
 
     void copyChildren(Node<K, V>* new_current, Node<K, V>* current) {
@@ -428,7 +841,7 @@ private:
 
         if (current->left) {
             new_current->left =
-                new Node<K, V>(current->left->key, current->left->value, new_current);
+                alloc_.create(current->left->data.first, current->left->data.second, new_current);
             new_current->left->color = current->left->color;
             copyChildren(new_current->left, current->left);
         } else {
@@ -437,7 +850,7 @@ private:
 
         if (current->right) {
             new_current->right =
-                new Node<K, V>(current->right->key, current->right->value, new_current);
+                alloc_.create(current->right->data.first, current->right->data.second, new_current);
             new_current->right->color = current->right->color;
             copyChildren(new_current->right, current->right);
         } else {
@@ -465,12 +878,11 @@ private:
                 root = nullptr;
             }
         }
-        delete to_del;
     }
 
     void fixDB(Node<K, V>* node) {
         if (node == root) {
-            node->color = Color::BLACK;
+            recolor(node, Color::BLACK);
             return;
         }
 
@@ -486,21 +898,21 @@ private:
             if (is_left) {
                 // Правый ребенок красный (левый - любой).
                 if (r_child && r_child->color == Color::RED) {
-                    sibling->color = pa->color;
-                    pa->color = Color::BLACK;
-                    r_child->color = Color::BLACK;
+                    recolor(sibling, pa->color);
+                    recolor(pa, Color::BLACK);
+                    recolor(r_child, Color::BLACK);
                     leftRotation(pa);
                     // Левый ребенок красный (правый - черный)
                 } else if (l_child && l_child->color == Color::RED && isBlack(r_child)) {
-                    l_child->color = Color::BLACK;
-                    sibling->color = Color::RED;
+                    recolor(l_child, Color::BLACK);
+                    recolor(sibling, Color::RED);
                     rightRotation(sibling);
                     fixDB(node);
                     // Оба ребенка брата - черные.
                 } else {
-                    sibling->color = Color::RED;
+                    recolor(sibling, Color::RED);
                     if (pa->color == Color::RED) {
-                        pa->color = Color::BLACK;
+                        recolor(pa, Color::BLACK);
                     } else {
                         fixDB(pa);
                     }
@@ -509,21 +921,21 @@ private:
             } else {
                 // Левый ребенок красный (правый - любой).
                 if (l_child && l_child->color == Color::RED) {
-                    sibling->color = pa->color;
-                    pa->color = Color::BLACK;
-                    l_child->color = Color::BLACK;
+                    recolor(sibling, pa->color);
+                    recolor(pa, Color::BLACK);
+                    recolor(l_child, Color::BLACK);
                     rightRotation(pa);
                     // Правый ребенок красный (левый - черный)
                 } else if (r_child && r_child->color == Color::RED && isBlack(l_child)) {
-                    r_child->color = Color::BLACK;
-                    sibling->color = Color::RED;
+                    recolor(r_child, Color::BLACK);
+                    recolor(sibling, Color::RED);
                     leftRotation(sibling);
                     fixDB(node);
                     // Оба ребенка брата - черные.
                 } else {
-                    sibling->color = Color::RED;
+                    recolor(sibling, Color::RED);
                     if (pa->color == Color::RED) {
-                        pa->color = Color::BLACK;
+                        recolor(pa, Color::BLACK);
                     } else {
                         fixDB(pa);
                     }
@@ -531,8 +943,8 @@ private:
             }
             // Брат красный.
         } else {
-            pa->color = Color::RED;
-            sibling->color = Color::BLACK;
+            recolor(pa, Color::RED);
+            recolor(sibling, Color::BLACK);
             if (is_left) {
                 leftRotation(pa);
             } else {
@@ -542,18 +954,122 @@ private:
         }
     }
 
+    static constexpr size_t kBatchLanes = 16;
+
+    static void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address);
+#endif
+    }
+
+    template <bool IsLowerBound>
+    void descendMany(std::span<const K> keys, std::span<Iterator> out) const {
+        const Node<K, V>* current[kBatchLanes];
+        const Node<K, V>* res[kBatchLanes];
+        for (size_t first = 0; first < keys.size(); first += kBatchLanes) {
+            size_t lanes = std::min(kBatchLanes, keys.size() - first);
+            for (size_t i = 0; i < lanes; ++i) {
+                current[i] = root;
+                res[i] = nullptr;
+            }
+            size_t active = lanes;
+            while (active > 0) {
+                active = 0;
+                for (size_t i = 0; i < lanes; ++i) {
+                    const Node<K, V>* node = current[i];
+                    if (!node) {
+                        continue;
+                    }
+                    const K& key = keys[first + i];
+                    auto order = compareKeys(node->data.first, key);
+                    if (order < 0) {
+                        node = node->right;
+                    } else if (order > 0) {
+                        if constexpr (IsLowerBound) {
+                            res[i] = node;
+                        }
+                        node = node->left;
+                    } else {
+                        res[i] = node;
+                        node = nullptr;
+                    }
+                    current[i] = node;
+                    if (node) {
+                        prefetch(node);
+                        ++active;
+                    }
+                }
+            }
+            for (size_t i = 0; i < lanes; ++i) {
+                out[first + i] = Iterator(res[i], root);
+            }
+        }
+    }
+
     bool isBlack(const Node<K, V>* node) const {
         return !node || node->color == Color::BLACK;
     }
 
-    Node<K, V>* findNode(const K& key) const {
+    // Одно трёхстороннее сравнение вместо пары вызовов comp_, если компаратор или
+    // ключи это позволяют.
+    template <typename A, typename B>
+    std::weak_ordering compareKeys(const A& first, const B& second) const {
+        counters_.addComparison();
+        return threeWay(comp_, first, second);
+    }
+
+    template <typename A, typename B>
+    bool keyLess(const A& first, const B& second) const {
+        counters_.addComparison();
+        return lessThan(comp_, first, second);
+    }
+
+    template <typename A, typename B>
+    bool equal(const A& first, const B& second) const {
+        return compareKeys(first, second) == 0;
+    }
+
+    void recolor(Node<K, V>* node, Color color) {
+        if (node->color != color) {
+            counters_.addRecolor();
+        }
+        node->color = color;
+    }
+
+    // Возвращает чёрную высоту поддерева, lo и hi — исключающие границы ключей.
+    size_t auditNode(const Node<K, V>* node, const Node<K, V>* pa, const K* lo, const K* hi,
+                     size_t& count) const {
+        if (!node) {
+            return 0;
+        }
+        ++count;
+        if (node->parent != pa) {
+            throw std::logic_error("Map audit: wrong parent link");
+        }
+        const K& key = node->data.first;
+        if ((lo && threeWay(comp_, *lo, key) >= 0) || (hi && threeWay(comp_, key, *hi) >= 0)) {
+            throw std::logic_error("Map audit: keys out of order");
+        }
+        if (node->color == Color::RED && (!isBlack(node->left) || !isBlack(node->right))) {
+            throw std::logic_error("Map audit: red node with a red child");
+        }
+        size_t left = auditNode(node->left, node, lo, &key, count);
+        size_t right = auditNode(node->right, node, &key, hi, count);
+        if (left != right) {
+            throw std::logic_error("Map audit: black heights differ");
+        }
+        return left + (node->color == Color::BLACK ? 1 : 0);
+    }
+
+    template <typename KeyLike>
+    Node<K, V>* findNode(const KeyLike& key) const {
         Node<K, V>* current = root;
-        while (current && !(current->key == key)) {
-            if (current->key < key) {
-                current = current->right;
-            } else {
-                current = current->left;
+        while (current) {
+            auto order = compareKeys(current->data.first, key);
+            if (order == 0) {
+                break;
             }
+            current = order < 0 ? current->right : current->left;
         }
         return current;
     }
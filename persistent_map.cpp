@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Персистентный словарь: insert и erase копируют только O(log n) вершин пути от корня,
+// остальные вершины разделяются между версиями. snapshot() за O(1) возвращает
+// неизменяемый срез, который можно читать из других потоков, пока писатель
+// продолжает менять словарь. Вершины считают ссылки и удаляются, как только
+// их не видит ни одна версия.
+//
+// Балансировка по высоте (AVL): в функциональном виде она заметно проще
+// красно-чёрной, а копирует те же O(log n) вершин.
+template <typename K, typename V, typename Compare = std::less<K>>
+class PersistentMap {
+    struct PNode {
+        std::pair<const K, V> data;
+        const PNode* left;
+        const PNode* right;
+        int height;
+        mutable std::atomic<size_t> refs;
+
+        PNode(const std::pair<const K, V>& data, const PNode* left, const PNode* right)
+            : data(data),
+              left(left),
+              right(right),
+              height(std::max(getHeight(left), getHeight(right)) + 1),
+              refs(0) {
+        }
+    };
+
+    static int getHeight(const PNode* node) {
+        return node ? node->height : 0;
+    }
+
+    static void acquire(const PNode* node) {
+        if (node) {
+            node->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static void release(const PNode* node) {
+        if (node && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            destroy(node);
+        }
+    }
+
+    static void destroy(const PNode* node) {
+        release(node->left);
+        release(node->right);
+        delete node;
+    }
+
+    // Удаляет вершину, созданную при перестройке, если на неё так никто и не сослался.
+    static void drop(const PNode* node) {
+        if (node && node->refs.load(std::memory_order_acquire) == 0) {
+            destroy(node);
+        }
+    }
+
+public:
+    struct Iterator {
+        Iterator() {
+        }
+
+        const std::pair<const K, V>& operator*() const {
+            return path_.back()->data;
+        }
+        const std::pair<const K, V>* operator->() const {
+            if (path_.empty()) {
+                return nullptr;
+            }
+            return &path_.back()->data;
+        }
+
+        Iterator& operator++() {
+            const PNode* node = path_.back()->right;
+            path_.pop_back();
+            pushLeft(node);
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator copy_it(*this);
+            ++(*this);
+            return copy_it;
+        }
+
+        bool operator==(const Iterator& other) const {
+            if (path_.empty() || other.path_.empty()) {
+                return path_.empty() && other.path_.empty();
+            }
+            return path_.back() == other.path_.back();
+        }
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        friend class PersistentMap;
+
+        // Стек предков, в левом поддереве которых находится текущая вершина, вершина сверху.
+        void pushLeft(const PNode* node) {
+            while (node) {
+                path_.push_back(node);
+                node = node->left;
+            }
+        }
+
+        std::vector<const PNode*> path_;
+    };
+
+    // Неизменяемая версия словаря. Держит ссылку на свой корень, поэтому итераторы
+    // действительны, пока жив срез.
+    class Snapshot {
+    public:
+        Snapshot() : root_(nullptr), size_(0) {
+        }
+        Snapshot(const Snapshot& other)
+            : root_(other.root_), size_(other.size_), comp_(other.comp_) {
+            acquire(root_);
+        }
+        Snapshot& operator=(const Snapshot& other) {
+            acquire(other.root_);
+            release(root_);
+            root_ = other.root_;
+            size_ = other.size_;
+            comp_ = other.comp_;
+            return *this;
+        }
+        ~Snapshot() {
+            release(root_);
+        }
+
+        size_t size() const {
+            return size_;
+        }
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        Iterator lowerBound(const K& key) const {
+            Iterator it;
+            const PNode* current = root_;
+            while (current) {
+                if (comp_(current->data.first, key)) {
+                    current = current->right;
+                } else {
+                    it.path_.push_back(current);
+                    current = current->left;
+                }
+            }
+            return it;
+        }
+
+        Iterator find(const K& key) const {
+            Iterator it = lowerBound(key);
+            if (it != end() && comp_(key, it->first)) {
+                return end();
+            }
+            return it;
+        }
+
+        Iterator begin() const {
+            Iterator it;
+            it.pushLeft(root_);
+            return it;
+        }
+        Iterator end() const {
+            return Iterator();
+        }
+
+    private:
+        friend class PersistentMap;
+
+        Snapshot(const PNode* root, size_t size, const Compare& comp)
+            : root_(root), size_(size), comp_(comp) {
+            acquire(root_);
+        }
+
+        const PNode* root_;
+        size_t size_;
+        Compare comp_;
+    };
+
+    PersistentMap() : root_(nullptr), size_(0) {
+    }
+    explicit PersistentMap(const Compare& comp) : root_(nullptr), size_(0), comp_(comp) {
+    }
+    PersistentMap(const PersistentMap& other)
+        : root_(other.root_), size_(other.size_), comp_(other.comp_) {
+        acquire(root_);
+    }
+    PersistentMap& operator=(const PersistentMap& other) {
+        acquire(other.root_);
+        release(root_);
+        root_ = other.root_;
+        size_ = other.size_;
+        comp_ = other.comp_;
+        return *this;
+    }
+    ~PersistentMap() {
+        release(root_);
+    }
+
+    // Изменения должны выполняться одним писателем (или под внешней блокировкой),
+    // снимки можно читать параллельно с ними.
+    void insert(const K& key, const V& value) {
+        replaceRoot(insertNode(root_, key, value));
+    }
+
+    void erase(const K& key) {
+        replaceRoot(eraseNode(root_, key));
+    }
+
+    Snapshot snapshot() const {
+        return Snapshot(root_, size_, comp_);
+    }
+
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+
+private:
+    const PNode* root_;
+    size_t size_;
+    Compare comp_;
+
+    void replaceRoot(const PNode* new_root) {
+        if (new_root == root_) {
+            return;
+        }
+        acquire(new_root);
+        release(root_);
+        root_ = new_root;
+    }
+
+    static const PNode* makeNode(const std::pair<const K, V>& data, const PNode* left,
+                                 const PNode* right) {
+        const PNode* node = new PNode(data, left, right);
+        acquire(left);
+        acquire(right);
+        return node;
+    }
+
+    // Собирает вершину с данными data и поддеревьями left, right, восстанавливая баланс.
+    static const PNode* balance(const std::pair<const K, V>& data, const PNode* left,
+                                const PNode* right) {
+        const PNode* res;
+        if (getHeight(left) > getHeight(right) + 1) {
+            if (getHeight(left->left) >= getHeight(left->right)) {
+                res = makeNode(left->data, left->left, makeNode(data, left->right, right));
+            } else {
+                const PNode* mid = left->right;
+                res = makeNode(mid->data, makeNode(left->data, left->left, mid->left),
+                               makeNode(data, mid->right, right));
+            }
+            drop(left);
+        } else if (getHeight(right) > getHeight(left) + 1) {
+            if (getHeight(right->right) >= getHeight(right->left)) {
+                res = makeNode(right->data, makeNode(data, left, right->left), right->right);
+            } else {
+                const PNode* mid = right->left;
+                res = makeNode(mid->data, makeNode(data, left, mid->left),
+                               makeNode(right->data, mid->right, right->right));
+            }
+            drop(right);
+        } else {
+            res = makeNode(data, left, right);
+        }
+        return res;
+    }
+
+    const PNode* insertNode(const PNode* node, const K& key, const V& value) {
+        if (!node) {
+            ++size_;
+            return makeNode({key, value}, nullptr, nullptr);
+        }
+        if (comp_(key, node->data.first)) {
+            return balance(node->data, insertNode(node->left, key, value), node->right);
+        }
+        if (comp_(node->data.first, key)) {
+            return balance(node->data, node->left, insertNode(node->right, key, value));
+        }
+        return makeNode({key, value}, node->left, node->right);
+    }
+
+    const PNode* eraseNode(const PNode* node, const K& key) {
+        if (!node) {
+            return nullptr;
+        }
+        if (comp_(key, node->data.first)) {
+            const PNode* left = eraseNode(node->left, key);
+            return left == node->left ? node : balance(node->data, left, node->right);
+        }
+        if (comp_(node->data.first, key)) {
+            const PNode* right = eraseNode(node->right, key);
+            return right == node->right ? node : balance(node->data, node->left, right);
+        }
+        --size_;
+        if (!node->left) {
+            return node->right;
+        }
+        if (!node->right) {
+            return node->left;
+        }
+        const PNode* successor = node->right;
+        while (successor->left) {
+            successor = successor->left;
+        }
+        return balance(successor->data, node->left, eraseMin(node->right));
+    }
+
+    static const PNode* eraseMin(const PNode* node) {
+        if (!node->left) {
+            return node->right;
+        }
+        return balance(node->data, eraseMin(node->left), node->right);
+    }
+};
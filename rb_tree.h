@@ -1,54 +1,70 @@
 #include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 #include <utility>
 
-enum Color { RED, BLACK, DOUBLE_BLACK };
+#include "slab_allocator.h"
+#include "three_way_compare.h"
+#include "tree_stats.h"
 
-template <typename ValueType>
-constexpr bool operator==(const ValueType& first, const ValueType& second) {
-    return !(first < second) && !(second < first);
-}
+enum Color { RED, BLACK, DOUBLE_BLACK };
 
+// Помимо ссылок дерева вершины связаны в двусвязный список в порядке возрастания,
+// по которому ходят итераторы.
 template <typename T>
 struct Node {
     T value;
     Node<T>* left;
     Node<T>* right;
     Node<T>* parent;
+    Node<T>* prev;
+    Node<T>* next;
     Color color;
 
-    Node() : value(), left(nullptr), right(nullptr), parent(nullptr), color(Color::RED) {
+    Node()
+        : value(),
+          left(nullptr),
+          right(nullptr),
+          parent(nullptr),
+          prev(nullptr),
+          next(nullptr),
+          color(Color::RED) {
     }
     explicit Node(const T& x)
-        : value(x), left(nullptr), right(nullptr), parent(nullptr), color(Color::RED) {
+        : value(x),
+          left(nullptr),
+          right(nullptr),
+          parent(nullptr),
+          prev(nullptr),
+          next(nullptr),
+          color(Color::RED) {
     }
     Node(T value, Node<T>* pa)
-        : value(value), left(nullptr), right(nullptr), parent(pa), color(Color::RED) {
+        : value(value),
+          left(nullptr),
+          right(nullptr),
+          parent(pa),
+          prev(nullptr),
+          next(nullptr),
+          color(Color::RED) {
     }
 };
 
-template <typename ValueType>
+template <typename ValueType, typename Allocator = SlabAllocator<Node<ValueType>>>
 class RBTree {
 public:
+    // Итератор идёт по списку prev/next: создание и каждый шаг стоят O(1) без подъёма
+    // по родителям. Дерево нужно только чтобы шагнуть из end() в --end().
     struct Iterator {
-        Iterator() : current_(nullptr), root_(nullptr) {
+        Iterator() : current_(nullptr), tree_(nullptr) {
         }
-
-        explicit Iterator(const Node<ValueType>* node) {
-            current_ = node;
-            if (!node) {
-                root_ = nullptr;
-                return;
-            }
-            root_ = node;
-            while (root_->parent) {
-                root_ = node->parent;
-            }
+        explicit Iterator(const Node<ValueType>* node) : current_(node), tree_(nullptr) {
         }
-
-        Iterator(const Node<ValueType>* node, const Node<ValueType>* root)
-            : current_(node), root_(root) {
+        Iterator(const Node<ValueType>* node, const RBTree* tree) : current_(node), tree_(tree) {
         }
 
         const ValueType& operator*() const {
@@ -59,52 +75,38 @@ public:
         }
 
         Iterator& operator++() {
-            if (!current_) {
-                current_ = mostLeft(root_);
-                return *this;
-            }
-            if (!current_->right) {
-                while (current_->parent && current_->parent->right == current_) {
-                    current_ = current_->parent;
-                }
-                current_ = current_->parent;
-            } else {
-                current_ = mostLeft(current_->right);
+            if (current_) {
+                current_ = current_->next;
+            } else if (tree_) {
+                current_ = tree_->head_;
             }
             return *this;
         }
         Iterator operator++(int) {
-            Iterator copy_it(this->current_);
+            Iterator copy_it(*this);
             ++(*this);
             return copy_it;
         }
 
         Iterator& operator--() {
-            if (!current_) {
-                current_ = mostRight(root_);
-                return *this;
-            }
-            if (!current_->left) {
-                while (current_->parent && current_->parent->left == current_) {
-                    current_ = current_->parent;
-                }
-                current_ = current_->parent;
-            } else {
-                current_ = mostRight(current_->left);
+            if (current_) {
+                current_ = current_->prev;
+            } else if (tree_) {
+                current_ = tree_->tail_;
             }
             return *this;
         }
         Iterator operator--(int) {
-            Iterator copy_it(this->current_, root_);
+            Iterator copy_it(*this);
             --(*this);
             return copy_it;
         }
 
         bool operator==(const Iterator& other) const {
-            return current_ == other.current_ && root_ == other.root_;
+            return current_ == other.current_;
         }
         bool operator!=(const Iterator& other) const {
-            return current_ != other.current_ || root_ != other.root_;
+            return current_ != other.current_;
         }
 
         static const Node<ValueType>* mostLeft(const Node<ValueType>* sub_tree) {
@@ -131,57 +133,112 @@ public:
 
     private:
         const Node<ValueType>* current_;
-        const Node<ValueType>* root_;
+        const RBTree* tree_;
     };
 
-    RBTree() : root(nullptr), size_(0) {
+    RBTree() : root(nullptr), size_(0), head_(nullptr), tail_(nullptr) {
     }
-    RBTree(std::initializer_list<ValueType> list) : root(nullptr), size_(0) {
+    RBTree(std::initializer_list<ValueType> list) : RBTree() {
         for (ValueType val : list) {
             insert(val);
         }
     }
-    RBTree(const RBTree& other) {
-        if (!other.root) {
-            root = nullptr;
-            size_ = 0;
-            return;
-        }
-        root = new Node<ValueType>(other.root->value);
-        root->color = Color::BLACK;
-        size_ = other.size_;
-        copyChildren(root, other.root);
+    // Вершины с первой вставки живут в общем теле со счётчиком ссылок. Копия стоит O(1)
+    // и ничего не выделяет: она берёт ещё одну ссылку на тело (атомарное увеличение
+    // счётчика) и не пишет в other, поэтому копировать можно, пока other читают другие
+    // потоки. Изменение дерева, тело которого разделено с копиями, сначала копирует
+    // вершины себе. Итераторы этого дерева после этого устаревают, а итераторы остальных
+    // деревьев остаются действительными. Одно и то же дерево по-прежнему нельзя менять
+    // одновременно с его чтением или копированием.
+    RBTree(const RBTree& other)
+        : root(other.root),
+          size_(other.size_),
+          head_(other.head_),
+          tail_(other.tail_),
+          body_(other.body_) {
+    }
+    RBTree(RBTree&& other) noexcept
+        : root(other.root),
+          size_(other.size_),
+          head_(other.head_),
+          tail_(other.tail_),
+          body_(std::move(other.body_)) {
+        other.root = nullptr;
+        other.size_ = 0;
+        other.head_ = nullptr;
+        other.tail_ = nullptr;
     }
 
-    RBTree<ValueType>& operator=(const RBTree& other) {
-        if (!other.root) {
-            root = nullptr;
-            size_ = 0;
-            return *this;
+    RBTree& operator=(const RBTree& other) {
+        if (this != &other) {
+            body_ = other.body_;
+            root = other.root;
+            size_ = other.size_;
+            head_ = other.head_;
+            tail_ = other.tail_;
         }
-        root = new Node<ValueType>(other.root->value);
-        root->color = Color::BLACK;
-        size_ = other.size_;
-        copyChildren(root, other.root);
+        return *this;
+    }
+
+    RBTree& operator=(RBTree&& other) noexcept {
+        std::swap(root, other.root);
+        std::swap(size_, other.size_);
+        std::swap(head_, other.head_);
+        std::swap(tail_, other.tail_);
+        std::swap(body_, other.body_);
         return *this;
     }
 
     ~RBTree() {
-        deleteNode(root);
+        clear();
+    }
+
+    // Явная копия вершин: создаются сразу, за один проход подряд в блоках аллокатора.
+    RBTree clone() const {
+        RBTree res;
+        if (root) {
+            res.body_ = std::make_shared<Body>();
+            res.cloneFrom(root, size_);
+        }
+        return res;
+    }
+
+    void clear() {
+        body_.reset();
+        root = nullptr;
+        size_ = 0;
+        head_ = nullptr;
+        tail_ = nullptr;
     }
 
     void insert(const ValueType& value) {
+        // Разделённое дерево копируется, только если вставка его действительно изменит.
+        if (isShared() && findNode(value)) {
+            return;
+        }
+        unshare();
         if (!root) {
-            root = new Node<ValueType>(value);
+            root = body_->alloc.create(value);
             root->color = Color::BLACK;
+            head_ = tail_ = root;
             ++size_;
-            return;
+        } else {
+            insertNode(root, value);
         }
-        Node<ValueType>* current = root;
-        insertNode(current, value);
+        body_->root = root;
     }
 
     void erase(const ValueType& value) {
+        Node<ValueType>* node = findNode(value);
+        if (!node) {
+            return;
+        }
+        if (isShared()) {
+            unshare();
+            node = findNode(value);
+        }
+        eraseNode(node);
+        body_->root = root;
     }
 
     size_t size() const {
@@ -193,28 +250,28 @@ public:
 
     Iterator lowerBound(const ValueType& value) const {
         if (!root) {
-            return Iterator(nullptr, root);
+            return Iterator(nullptr, this);
         }
         Node<ValueType>* current = root;
-        while (current->right && current->value < value) {
+        while (current->right && less(current->value, value)) {
             current = current->right;
         }
-        if (current->value < value) {
-            return Iterator(nullptr, root);
+        if (less(current->value, value)) {
+            return Iterator(nullptr, this);
         }
-        while (current->left && value < current->left->value) {
+        while (current->left && less(value, current->left->value)) {
             current = current->left;
         }
-        if (current->left && value == current->left->value) {
+        if (current->left && compare(value, current->left->value) == 0) {
             current = current->left;
         }
-        return Iterator(current, root);
+        return Iterator(current, this);
     }
 
     Iterator true_lowerBound(const ValueType& value) const {
         auto it = begin();
         for (; it != end(); ++it) {
-            if (value < *it || value == *it) {
+            if (compare(value, *it) <= 0) {
                 return it;
             }
         }
@@ -222,48 +279,366 @@ public:
     }
 
     Iterator find(const ValueType& value) const {
-        Node<ValueType>* current = root;
-        while (current && !(current->value == value)) {
-            if (current->value < value) {
-                current = current->right;
-            } else {
-                current = current->left;
+        return Iterator(findNode(value), this);
+    }
+
+    // Форма дерева обходом за O(n) и счётчики операций (см. TREE_STATS в tree_stats.h).
+    TreeStats stats() const {
+        TreeStats res;
+        collectShape(root, res);
+        for (const Node<ValueType>* node = root; node; node = node->left) {
+            if (node->color == Color::BLACK) {
+                ++res.black_height;
+            }
+        }
+        res.bytes_used = sizeof(*this) + res.node_count * sizeof(Node<ValueType>);
+        counters_.fill(res);
+        return res;
+    }
+
+    void resetStats() {
+        counters_.reset();
+    }
+
+    // Проверяет порядок ключей, ссылки на родителей, отсутствие двух красных вершин
+    // подряд, равенство чёрных высот, размер и список prev/next. Стоит O(n); при
+    // нарушении бросает std::logic_error.
+    void audit() const {
+        if (root && (root->parent || root->color != Color::BLACK)) {
+            throw std::logic_error("RBTree audit: root must be black and have no parent");
+        }
+        auditNode(root, nullptr, nullptr, nullptr);
+        size_t count = 0;
+        const Node<ValueType>* prev = nullptr;
+        for (const Node<ValueType>* node = head_; node; node = node->next) {
+            if (node->prev != prev || (prev && threeWay(prev->value, node->value) >= 0)) {
+                throw std::logic_error("RBTree audit: broken in-order list");
             }
+            prev = node;
+            ++count;
+        }
+        if (prev != tail_ || count != size_) {
+            throw std::logic_error("RBTree audit: size or list end mismatch");
         }
-        return Iterator(current, root);
     }
 
     Iterator begin() const {
-        return Iterator(Iterator::mostLeft(root), root);
+        return Iterator(head_, this);
     }
     Iterator end() const {
-        return Iterator(nullptr, root);
+        return Iterator(nullptr, this);
     }
 
     Node<ValueType>* root;
 
 private:
     size_t size_;
+    Node<ValueType>* head_;
+    Node<ValueType>* tail_;
+
+    TreeCounters counters_;
+
+    template <typename A, typename B>
+    auto compare(const A& first, const B& second) const {
+        counters_.addComparison();
+        return threeWay(first, second);
+    }
+
+    template <typename A, typename B>
+    bool less(const A& first, const B& second) const {
+        counters_.addComparison();
+        return first < second;
+    }
+
+    void recolor(Node<ValueType>* node, Color color) {
+        if (node->color != color) {
+            counters_.addRecolor();
+        }
+        node->color = color;
+    }
+
+    // Возвращает чёрную высоту поддерева, lo и hi — исключающие границы ключей.
+    size_t auditNode(const Node<ValueType>* node, const Node<ValueType>* pa, const ValueType* lo,
+                     const ValueType* hi) const {
+        if (!node) {
+            return 0;
+        }
+        if (node->parent != pa) {
+            throw std::logic_error("RBTree audit: wrong parent link");
+        }
+        if ((lo && threeWay(*lo, node->value) >= 0) || (hi && threeWay(node->value, *hi) >= 0)) {
+            throw std::logic_error("RBTree audit: keys out of order");
+        }
+        if (node->color == Color::RED && (!isBlack(node->left) || !isBlack(node->right))) {
+            throw std::logic_error("RBTree audit: red node with a red child");
+        }
+        size_t left = auditNode(node->left, node, lo, &node->value);
+        size_t right = auditNode(node->right, node, &node->value, hi);
+        if (left != right) {
+            throw std::logic_error("RBTree audit: black heights differ");
+        }
+        return left + (node->color == Color::BLACK ? 1 : 0);
+    }
+
+    // Владеет вершинами и их памятью. root обновляется после каждого изменения, чтобы
+    // последний владелец тела мог вызвать деструкторы значений.
+    struct Body {
+        Node<ValueType>* root = nullptr;
+        Allocator alloc;
+
+        ~Body() {
+            if constexpr (!std::is_trivially_destructible_v<Node<ValueType>>) {
+                destroyNodes(root);
+            }
+        }
+    };
+
+    std::shared_ptr<Body> body_;
+
+    bool isShared() const {
+        return body_ && body_.use_count() > 1;
+    }
+
+    // Вызывается перед изменением: заводит тело для первой вершины или, если тело
+    // разделено с копиями, копирует вершины в собственное.
+    void unshare() {
+        if (!body_) {
+            body_ = std::make_shared<Body>();
+            return;
+        }
+        if (body_.use_count() == 1) {
+            // Синхронизируется с освобождением ссылок копиями в других потоках.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return;
+        }
+        // Старое тело держится до конца копирования, даже если остальные копии тем
+        // временем исчезнут.
+        std::shared_ptr<Body> old_body = std::move(body_);
+        const Node<ValueType>* old_root = root;
+        size_t count = size_;
+        body_ = std::make_shared<Body>();
+        root = head_ = tail_ = nullptr;
+        size_ = 0;
+        cloneFrom(old_root, count);
+    }
 
-    void deleteNode(Node<ValueType>* node) {
+    static void destroyNodes(Node<ValueType>* node) {
         if (!node) {
             return;
         }
-        deleteNode(node->left);
-        deleteNode(node->right);
-        delete node;
+        destroyNodes(node->left);
+        destroyNodes(node->right);
+        std::destroy_at(node);
+    }
+
+    Node<ValueType>* findNode(const ValueType& value) const {
+        Node<ValueType>* current = root;
+        while (current) {
+            auto order = compare(current->value, value);
+            if (order == 0) {
+                break;
+            }
+            current = order < 0 ? current->right : current->left;
+        }
+        return current;
+    }
+
+    // Вершины не обмениваются значениями, а перевешиваются, поэтому итераторы на остальные
+    // элементы остаются действительными. Освобождённая вершина уходит в список свободных
+    // аллокатора, и следующая вставка возьмёт её оттуда.
+    void eraseNode(Node<ValueType>* node) {
+        Node<ValueType>* child;
+        Node<ValueType>* pa;
+        Color removed = node->color;
+        if (!node->left || !node->right) {
+            child = node->left ? node->left : node->right;
+            pa = node->parent;
+            replaceInParent(node, child);
+        } else {
+            // Две дочерние вершины: место node занимает следующая за ней.
+            Node<ValueType>* next = node->right;
+            while (next->left) {
+                next = next->left;
+            }
+            removed = next->color;
+            child = next->right;
+            if (next->parent == node) {
+                pa = next;
+            } else {
+                pa = next->parent;
+                replaceInParent(next, child);
+                next->right = node->right;
+                next->right->parent = next;
+            }
+            replaceInParent(node, next);
+            next->left = node->left;
+            next->left->parent = next;
+            next->color = node->color;
+        }
+        if (removed == Color::BLACK) {
+            fixErase(child, pa);
+        }
+        unlink(node);
+        --size_;
+        body_->alloc.destroy(node);
+    }
+
+    // Вставляет node в список сразу после prev (в начало, если prev пуст).
+    void linkAfter(Node<ValueType>* node, Node<ValueType>* prev) {
+        node->prev = prev;
+        node->next = prev ? prev->next : head_;
+        if (node->prev) {
+            node->prev->next = node;
+        } else {
+            head_ = node;
+        }
+        if (node->next) {
+            node->next->prev = node;
+        } else {
+            tail_ = node;
+        }
+    }
+
+    void unlink(Node<ValueType>* node) {
+        if (node->prev) {
+            node->prev->next = node->next;
+        } else {
+            head_ = node->next;
+        }
+        if (node->next) {
+            node->next->prev = node->prev;
+        } else {
+            tail_ = node->prev;
+        }
+    }
+
+    void replaceInParent(Node<ValueType>* old_node, Node<ValueType>* node) {
+        if (!old_node->parent) {
+            root = node;
+        } else if (old_node->parent->left == old_node) {
+            old_node->parent->left = node;
+        } else {
+            old_node->parent->right = node;
+        }
+        if (node) {
+            node->parent = old_node->parent;
+        }
+    }
+
+    static bool isBlack(const Node<ValueType>* node) {
+        return !node || node->color == Color::BLACK;
+    }
+
+    // На пути через node (возможно, пустую) с родителем pa не хватает одной чёрной вершины.
+    void fixErase(Node<ValueType>* node, Node<ValueType>* pa) {
+        while (node != root && isBlack(node)) {
+            bool is_left = pa->left == node;
+            Node<ValueType>* sibling = is_left ? pa->right : pa->left;
+            // Случай 1: брат красный — поворот делает его чёрным.
+            if (sibling->color == Color::RED) {
+                recolor(sibling, Color::BLACK);
+                recolor(pa, Color::RED);
+                if (is_left) {
+                    leftRotation(pa);
+                } else {
+                    rightRotation(pa);
+                }
+                sibling = is_left ? pa->right : pa->left;
+            }
+            Node<ValueType>* near = is_left ? sibling->left : sibling->right;
+            Node<ValueType>* far = is_left ? sibling->right : sibling->left;
+            // Случай 2: оба ребёнка брата чёрные — недостача поднимается к родителю.
+            if (isBlack(near) && isBlack(far)) {
+                recolor(sibling, Color::RED);
+                node = pa;
+                pa = node->parent;
+                continue;
+            }
+            // Случай 3: дальний ребёнок брата чёрный — сводится к случаю 4.
+            if (isBlack(far)) {
+                recolor(near, Color::BLACK);
+                recolor(sibling, Color::RED);
+                if (is_left) {
+                    rightRotation(sibling);
+                } else {
+                    leftRotation(sibling);
+                }
+                far = sibling;
+                sibling = near;
+            }
+            // Случай 4: дальний ребёнок брата красный.
+            recolor(sibling, pa->color);
+            recolor(pa, Color::BLACK);
+            recolor(far, Color::BLACK);
+            if (is_left) {
+                leftRotation(pa);
+            } else {
+                rightRotation(pa);
+            }
+            node = root;
+        }
+        if (node) {
+            recolor(node, Color::BLACK);
+        }
+    }
+
+    // Копирует дерево за один проход без рекурсии: явный стек хранит левый край
+    // ещё не пройденной части, копии создаются в прямом порядке подряд в блоках аллокатора
+    // и связываются в список в момент симметричного обхода.
+    void cloneFrom(const Node<ValueType>* other_root, size_t count) {
+        if (!other_root) {
+            return;
+        }
+        std::vector<std::pair<const Node<ValueType>*, Node<ValueType>*>> path;
+        root = copyNode(other_root, nullptr);
+        pushLeftEdge(other_root, root, path);
+        while (!path.empty()) {
+            auto [src, dst] = path.back();
+            path.pop_back();
+            linkAfter(dst, tail_);
+            if (src->right) {
+                dst->right = copyNode(src->right, dst);
+                pushLeftEdge(src->right, dst->right, path);
+            }
+        }
+        size_ = count;
+        body_->root = root;
+    }
+
+    void pushLeftEdge(const Node<ValueType>* src, Node<ValueType>* dst,
+                      std::vector<std::pair<const Node<ValueType>*, Node<ValueType>*>>& path) {
+        while (true) {
+            path.emplace_back(src, dst);
+            if (!src->left) {
+                return;
+            }
+            dst->left = copyNode(src->left, dst);
+            src = src->left;
+            dst = dst->left;
+        }
+    }
+
+    Node<ValueType>* copyNode(const Node<ValueType>* node, Node<ValueType>* pa) {
+        Node<ValueType>* res = body_->alloc.create(node->value, pa);
+        res->color = node->color;
+        return res;
     }
 
     void insertNode(Node<ValueType>* current, ValueType value) {
-        if (!current || value == current->value) {
+        if (!current) {
+            return;
+        }
+        auto order = compare(current->value, value);
+        if (order == 0) {
             return;
         }
-        if (current->value < value) {
+        if (order < 0) {
             if (current->right) {
                 insertNode(current->right, value);
             } else {
-                Node<ValueType>* new_node = new Node<ValueType>(value, current);
+                Node<ValueType>* new_node = body_->alloc.create(value, current);
                 current->right = new_node;
+                linkAfter(new_node, current);
                 balance(new_node);
                 ++size_;
             }
@@ -271,8 +646,9 @@ private:
             if (current->left) {
                 insertNode(current->left, value);
             } else {
-                Node<ValueType>* new_node = new Node<ValueType>(value, current);
+                Node<ValueType>* new_node = body_->alloc.create(value, current);
                 current->left = new_node;
+                linkAfter(new_node, current->prev);
                 balance(new_node);
                 ++size_;
             }
@@ -280,6 +656,7 @@ private:
     }
 
     void rightRotation(Node<ValueType>* pivot) {
+        counters_.addRotation();
         Node<ValueType>* node = pivot->left;
         if (pivot->parent) {
             if (pivot->parent->right == pivot) {
@@ -301,6 +678,7 @@ private:
     }
 
     void leftRotation(Node<ValueType>* pivot) {
+        counters_.addRotation();
         Node<ValueType>* node = pivot->right;
         if (pivot->parent) {
             if (pivot->parent->right == pivot) {
@@ -324,11 +702,11 @@ private:
     void balance(Node<ValueType>* son) {
         // Случай 3: корень красный.
         if (son == root) {
-            son->color = Color::BLACK;
+            recolor(son, Color::BLACK);
             return;
         }
         if (son->parent == root) {
-            son->parent->color = Color::BLACK;
+            recolor(son->parent, Color::BLACK);
             return;
         }
         if (son->color == Color::BLACK || son->parent->color == Color::BLACK) {
@@ -341,9 +719,9 @@ private:
 
         // Случай 1 (и 2): дядя красный.
         if (uncle && uncle->color == Color::RED) {
-            pa->color = Color::BLACK;
-            uncle->color = Color::BLACK;
-            grandpa->color = Color::RED;
+            recolor(pa, Color::BLACK);
+            recolor(uncle, Color::BLACK);
+            recolor(grandpa, Color::RED);
             balance(grandpa);
         } else {
             // Случай 4 (и 5): дядя чёрный или его нет.
@@ -360,30 +738,8 @@ private:
                 }
                 leftRotation(grandpa);
             }
-            grandpa->color = Color::RED;
-            pa->color = Color::BLACK;
-        }
-    }
-
-    void copyChildren(Node<ValueType>* new_current, Node<ValueType>* current) {
-        if (!new_current) {
-            return;
-        }
-
-        if (current->left) {
-            new_current->left = new Node<ValueType>(current->left->value, new_current);
-            new_current->left->color = current->left->color;
-            copyChildren(new_current->left, current->left);
-        } else {
-            new_current->left = nullptr;
-        }
-
-        if (current->right) {
-            new_current->right = new Node<ValueType>(current->right->value, new_current);
-            new_current->right->color = current->right->color;
-            copyChildren(new_current->right, current->right);
-        } else {
-            new_current->left = nullptr;
+            recolor(grandpa, Color::RED);
+            recolor(pa, Color::BLACK);
         }
     }
 };
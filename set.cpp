@@ -1,53 +1,280 @@
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 #include <utility>
 
+#include "slab_allocator.h"
+#include "three_way_compare.h"
+
 enum Color { RED, BLACK };
 
-template <typename ValueType>
-constexpr bool operator==(const ValueType& first, const ValueType& second) {
-    return !(first < second) && !(second < first);
-}
+// Аугментация дерева моноидом: в каждой вершине хранится свёртка значений её поддерева,
+// которая пересчитывается при вставке, удалении и поворотах. Моноид задаёт тип Summary,
+// нейтральный элемент identity(), значение одной вершины lift(x) и ассоциативную
+// операцию combine(a, b); коммутативность не требуется, свёртка идёт слева направо.
+template <typename T>
+struct NoAugment {
+    struct Summary {};
+
+    static Summary identity() {
+        return {};
+    }
+    static Summary lift(const T&) {
+        return {};
+    }
+    static Summary combine(const Summary&, const Summary&) {
+        return {};
+    }
+};
 
 template <typename T>
+struct SumMonoid {
+    using Summary = T;
+
+    static Summary identity() {
+        return T();
+    }
+    static Summary lift(const T& value) {
+        return value;
+    }
+    static Summary combine(const Summary& first, const Summary& second) {
+        return first + second;
+    }
+};
+
+// Нейтральные элементы min и max берутся из numeric_limits, поэтому эти моноиды
+// только для арифметических типов; для прочих нужен свой моноид с явным identity().
+template <typename T>
+    requires std::is_arithmetic_v<T>
+struct MinMonoid {
+    using Summary = T;
+
+    static Summary identity() {
+        return std::numeric_limits<T>::max();
+    }
+    static Summary lift(const T& value) {
+        return value;
+    }
+    static Summary combine(const Summary& first, const Summary& second) {
+        return std::min(first, second);
+    }
+};
+
+template <typename T>
+    requires std::is_arithmetic_v<T>
+struct MaxMonoid {
+    using Summary = T;
+
+    static Summary identity() {
+        return std::numeric_limits<T>::lowest();
+    }
+    static Summary lift(const T& value) {
+        return value;
+    }
+    static Summary combine(const Summary& first, const Summary& second) {
+        return std::max(first, second);
+    }
+};
+
+template <typename T, typename Augment = NoAugment<T>>
 struct Node {
+    using Summary = typename Augment::Summary;
+
     T value;
-    Node<T>* left;
-    Node<T>* right;
-    Node<T>* parent;
+    Node* left;
+    Node* right;
+    Node* parent;
     Color color;
     size_t sub_size;
+    [[no_unique_address]] Summary summary;
 
-    Node() : value(), left(nullptr), right(nullptr), parent(nullptr), color(Color::RED), sub_size(1) {
+    Node()
+        : value(),
+          left(nullptr),
+          right(nullptr),
+          parent(nullptr),
+          color(Color::RED),
+          sub_size(1),
+          summary(Augment::lift(value)) {
     }
     explicit Node(const T& x)
-        : value(x), left(nullptr), right(nullptr), parent(nullptr), color(Color::RED), sub_size(1) {
+        : value(x),
+          left(nullptr),
+          right(nullptr),
+          parent(nullptr),
+          color(Color::RED),
+          sub_size(1),
+          summary(Augment::lift(value)) {
     }
-    Node(T value, Node<T>* pa)
-        : value(value), left(nullptr), right(nullptr), parent(pa), color(Color::RED), sub_size(1) {
+    Node(T value, Node* pa)
+        : value(std::move(value)),
+          left(nullptr),
+          right(nullptr),
+          parent(pa),
+          color(Color::RED),
+          sub_size(1),
+          summary(Augment::lift(this->value)) {
     }
 };
 
-template <typename ValueType>
+template <typename ValueType, typename Augment = NoAugment<ValueType>,
+          typename Allocator = SlabAllocator<Node<ValueType, Augment>>>
 class RBTree {
+    using Node = ::Node<ValueType, Augment>;
+    using Summary = typename Augment::Summary;
+
 public:
-    static Node<ValueType>* mostLeft(Node<ValueType>* sub_tree) {
+    // Итератор знает свой номер через sub_size: сдвиг на n и разность итераторов
+    // стоят O(log n), ++ и -- — амортизированно O(1).
+    class Iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = ValueType;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const ValueType*;
+        using reference = const ValueType&;
+
+        Iterator() : current_(nullptr), tree_(nullptr) {
+        }
+        Iterator(const Node* node, const RBTree* tree) : current_(node), tree_(tree) {
+        }
+
+        const ValueType& operator*() const {
+            return current_->value;
+        }
+        const ValueType* operator->() const {
+            return &current_->value;
+        }
+        const ValueType& operator[](difference_type n) const {
+            return *(*this + n);
+        }
+
+        Iterator& operator++() {
+            if (!current_) {
+                current_ = mostLeft(tree_->root);
+            } else if (current_->right) {
+                current_ = mostLeft(current_->right);
+            } else {
+                while (current_->parent && current_->parent->right == current_) {
+                    current_ = current_->parent;
+                }
+                current_ = current_->parent;
+            }
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator copy_it(*this);
+            ++(*this);
+            return copy_it;
+        }
+
+        Iterator& operator--() {
+            if (!current_) {
+                current_ = mostRight(tree_->root);
+            } else if (current_->left) {
+                current_ = mostRight(current_->left);
+            } else {
+                while (current_->parent && current_->parent->left == current_) {
+                    current_ = current_->parent;
+                }
+                current_ = current_->parent;
+            }
+            return *this;
+        }
+        Iterator operator--(int) {
+            Iterator copy_it(*this);
+            --(*this);
+            return copy_it;
+        }
+
+        Iterator& operator+=(difference_type n) {
+            current_ = tree_->nodeAt(index() + n);
+            return *this;
+        }
+        Iterator& operator-=(difference_type n) {
+            return *this += -n;
+        }
+        Iterator operator+(difference_type n) const {
+            Iterator res(*this);
+            return res += n;
+        }
+        friend Iterator operator+(difference_type n, const Iterator& it) {
+            return it + n;
+        }
+        Iterator operator-(difference_type n) const {
+            Iterator res(*this);
+            return res -= n;
+        }
+        difference_type operator-(const Iterator& other) const {
+            return static_cast<difference_type>(index()) -
+                   static_cast<difference_type>(other.index());
+        }
+
+        // Номер элемента в порядке возрастания, для end() — размер дерева.
+        size_t index() const {
+            if (!current_) {
+                return tree_ ? tree_->size_ : 0;
+            }
+            size_t res = getSize(current_->left);
+            for (const Node* node = current_; node->parent; node = node->parent) {
+                if (node->parent->right == node) {
+                    res += getSize(node->parent->left) + 1;
+                }
+            }
+            return res;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return current_ == other.current_ && tree_ == other.tree_;
+        }
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+        bool operator<(const Iterator& other) const {
+            return *this - other < 0;
+        }
+        bool operator>(const Iterator& other) const {
+            return other < *this;
+        }
+        bool operator<=(const Iterator& other) const {
+            return !(other < *this);
+        }
+        bool operator>=(const Iterator& other) const {
+            return !(*this < other);
+        }
+
+    private:
+        const Node* current_;
+        const RBTree* tree_;
+    };
+
+    static Node* mostLeft(Node* sub_tree) {
         if (!sub_tree) {
             return nullptr;
         }
-        Node<ValueType>* current = sub_tree;
+        Node* current = sub_tree;
         while (current->left) {
             current = current->left;
         }
         return current;
     }
 
-    static Node<ValueType>* mostRight(Node<ValueType>* sub_tree) {
+    static Node* mostRight(Node* sub_tree) {
         if (!sub_tree) {
             return nullptr;
         }
-        Node<ValueType>* current = sub_tree;
+        Node* current = sub_tree;
         while (current->right) {
             current = current->right;
         }
@@ -58,37 +285,122 @@ public:
     }
 
     ~RBTree() {
-        deleteNode(root);
+        clear();
     }
 
+    void clear() {
+        if constexpr (!std::is_trivially_destructible_v<Node>) {
+            destroyNodes(root);
+        }
+        alloc_.release();
+        root = nullptr;
+        size_ = 0;
+    }
+
+    // e-я порядковая статистика, нумерация с единицы.
     ValueType eStatistic(size_t e) {
-        Node<ValueType>* current = root;
-        size_t cur_stat = getSize(current->left) + 1;
-        while (cur_stat != e) {
-            if (cur_stat > e) {
-                current = current->left;
-                cur_stat -= getSize(current->right) + 1;
+        return select(e - 1);
+    }
+
+    // Количество элементов, меньших value.
+    size_t rank(const ValueType& value) const {
+        size_t res = 0;
+        Node* current = root;
+        while (current) {
+            auto order = threeWay(current->value, value);
+            if (order < 0) {
+                res += getSize(current->left) + 1;
+                current = current->right;
             } else {
+                if (order == 0) {
+                    return res + getSize(current->left);
+                }
+                current = current->left;
+            }
+        }
+        return res;
+    }
+
+    // k-й по возрастанию элемент, нумерация с нуля.
+    const ValueType& select(size_t k) const {
+        if (k >= size_) {
+            throw std::out_of_range("RBTree::select: index out of range");
+        }
+        return nodeAt(k)->value;
+    }
+
+    // Элементы с номерами из ranks за один общий спуск: общие части путей к соседним
+    // номерам проходятся один раз. ranks должны идти по неубыванию (повторы допустимы),
+    // иначе бросается std::invalid_argument.
+    void selectMany(std::span<const size_t> ranks, std::span<ValueType> out) const {
+        if (out.size() < ranks.size()) {
+            throw std::invalid_argument("RBTree::selectMany: output is too short");
+        }
+        if (!std::is_sorted(ranks.begin(), ranks.end())) {
+            throw std::invalid_argument("RBTree::selectMany: ranks must be sorted");
+        }
+        if (!ranks.empty() && ranks.back() >= size_) {
+            throw std::out_of_range("RBTree::selectMany: index out of range");
+        }
+        selectMany(root, 0, ranks, out.data());
+    }
+
+    // Свёртка моноида по элементам из [lo, hi) за O(log n): спуск до первой вершины
+    // диапазона, затем по одному пути к каждой из границ.
+    Summary aggregate(const ValueType& lo, const ValueType& hi) const {
+        Node* current = root;
+        while (current) {
+            if (less(current->value, lo)) {
                 current = current->right;
-                cur_stat += getSize(current->left) + 1;
+            } else if (!less(current->value, hi)) {
+                current = current->left;
+            } else {
+                break;
             }
         }
-        return current->value;
+        if (!current) {
+            return Augment::identity();
+        }
+        Summary res = Augment::combine(suffixFrom(current->left, lo),
+                                       Augment::lift(current->value));
+        return Augment::combine(res, prefixBelow(current->right, hi));
+    }
+
+    // Операции над множествами устроены как разделяй и властвуй через split и join:
+    // работа O(m log(n / m + 1)), где m ≤ n — размеры множеств, а две независимые
+    // половины верхних уровней рекурсии считаются в разных потоках.
+    // Вершины other переходят в это дерево, other остаётся пустым.
+    void unionWith(RBTree&& other) {
+        combineWith(std::move(other), [this](Subtree first, Subtree second, size_t depth) {
+            return unite(first, second, depth);
+        });
+    }
+
+    void intersectWith(RBTree&& other) {
+        combineWith(std::move(other), [this](Subtree first, Subtree second, size_t depth) {
+            return intersect(first, second, depth);
+        });
+    }
+
+    void differenceWith(RBTree&& other) {
+        combineWith(std::move(other), [this](Subtree first, Subtree second, size_t depth) {
+            return subtract(first, second, depth);
+        });
     }
 
     void insert(const ValueType& value) {
         if (!root) {
-            root = new Node<ValueType>(value);
+            root = alloc_.create(value);
             root->color = Color::BLACK;
             ++size_;
             return;
         }
-        Node<ValueType>* current = root;
+        Node* current = root;
         insertNode(current, value);
     }
 
     void erase(const ValueType& value) {
-        Node<ValueType>* to_del = findNode(value);
+        Node* to_del = findNode(value);
         if (!to_del) {
             return;
         }
@@ -98,7 +410,7 @@ public:
             delLeaf(to_del);
             // Вершина с двумя потомками.
         } else if (to_del->right && to_del->left) {
-            Node<ValueType>* ios = mostRight(to_del->left);
+            Node* ios = mostRight(to_del->left);
             std::swap(ios->value, to_del->value);
             if (ios->left || ios->right) {
                 delOnlyChild(ios);
@@ -112,7 +424,30 @@ public:
         --size_;
     }
 
-    void delOnlyChild(Node<ValueType>* to_del) {
+    // Удаляет элементы из [lo, hi) за O(log n + k), где k — число удалённых:
+    // диапазон вырезается двумя split и остаток склеивается одним join.
+    size_t eraseRange(const ValueType& lo, const ValueType& hi) {
+        if (!less(lo, hi)) {
+            return 0;
+        }
+        return eraseRanks(rank(lo), rank(hi));
+    }
+
+    // Удаляет элементы с номерами из [first, last).
+    size_t eraseRanks(size_t first, size_t last) {
+        last = std::min(last, size_);
+        if (first >= last) {
+            return 0;
+        }
+        auto [head, rest] = splitRank({root, blackHeight(root)}, first);
+        auto [middle, tail] = splitRank(rest, last - first);
+        root = joinPair(head, tail).root;
+        size_ -= last - first;
+        destroySubtree(middle.root);
+        return last - first;
+    }
+
+    void delOnlyChild(Node* to_del) {
         // Только правый ребёнок.
         if (to_del->right) {
             std::swap(to_del->value, to_del->right->value);
@@ -124,7 +459,7 @@ public:
         }
     }
 
-    void delLeaf(Node<ValueType>* to_del) {
+    void delLeaf(Node* to_del) {
         if (to_del->color == Color::RED) {
             auto pa = to_del->parent;
             if (pa->right == to_del) {
@@ -145,19 +480,19 @@ public:
             }
         }
         updateSize(to_del->parent);
-        delete to_del;
+        alloc_.destroy(to_del);
     }
 
-    void fixDB(Node<ValueType>* node) {
+    void fixDB(Node* node) {
         if (node == root) {
             node->color = Color::BLACK;
             return;
         }
 
-        Node<ValueType>* pa = node->parent;
-        Node<ValueType>* sibling = pa->right == node ? pa->left : pa->right;
-        Node<ValueType>* l_child = sibling->left;
-        Node<ValueType>* r_child = sibling->right;
+        Node* pa = node->parent;
+        Node* sibling = pa->right == node ? pa->left : pa->right;
+        Node* l_child = sibling->left;
+        Node* r_child = sibling->right;
         bool is_left = pa->left == node;
 
         // Брат чёрный.
@@ -169,12 +504,12 @@ public:
                     sibling->color = pa->color;
                     pa->color = Color::BLACK;
                     r_child->color = Color::BLACK;
-                    leftRotation(pa);
+                    leftRotation(pa, root);
                     // Левый ребенок красный (правый - черный)
                 } else if (l_child && l_child->color == Color::RED && isBlack(r_child)) {
                     l_child->color = Color::BLACK;
                     sibling->color = Color::RED;
-                    rightRotation(sibling);
+                    rightRotation(sibling, root);
                     fixDB(node);
                     // Оба ребенка брата - черные.
                 } else {
@@ -192,12 +527,12 @@ public:
                     sibling->color = pa->color;
                     pa->color = Color::BLACK;
                     l_child->color = Color::BLACK;
-                    rightRotation(pa);
+                    rightRotation(pa, root);
                     // Правый ребенок красный (левый - черный)
                 } else if (r_child && r_child->color == Color::RED && isBlack(l_child)) {
                     r_child->color = Color::BLACK;
                     sibling->color = Color::RED;
-                    leftRotation(sibling);
+                    leftRotation(sibling, root);
                     fixDB(node);
                     // Оба ребенка брата - черные.
                 } else {
@@ -214,18 +549,25 @@ public:
             pa->color = Color::RED;
             sibling->color = Color::BLACK;
             if (is_left) {
-                leftRotation(pa);
+                leftRotation(pa, root);
             } else {
-                rightRotation(pa);
+                rightRotation(pa, root);
             }
             fixDB(node);
         }
     }
 
-    bool isBlack(Node<ValueType>* node) {
+    bool isBlack(Node* node) {
         return !node || node->color == Color::BLACK;
     }
 
+    Iterator begin() const {
+        return Iterator(mostLeft(root), this);
+    }
+    Iterator end() const {
+        return Iterator(nullptr, this);
+    }
+
     size_t size() const {
         return size_;
     }
@@ -233,63 +575,385 @@ public:
         return size_ == 0;
     }
 
-    Node<ValueType>* findNode(const ValueType& value) const {
-        Node<ValueType>* current = root;
-        while (current && !(current->value == value)) {
-            if (current->value < value) {
-                current = current->right;
-            } else {
-                current = current->left;
+    Node* findNode(const ValueType& value) const {
+        Node* current = root;
+        while (current) {
+            auto order = threeWay(current->value, value);
+            if (order == 0) {
+                break;
             }
+            current = order < 0 ? current->right : current->left;
         }
         return current;
     }
 
-    Node<ValueType>* root;
+    Node* root;
 
 private:
     size_t size_;
 
-    void deleteNode(Node<ValueType>* node) {
+    Allocator alloc_;
+
+    static void selectMany(const Node* node, size_t offset, std::span<const size_t> ranks,
+                           ValueType* out) {
+        if (ranks.empty()) {
+            return;
+        }
+        size_t pos = offset + getSize(node->left);
+        size_t first = std::lower_bound(ranks.begin(), ranks.end(), pos) - ranks.begin();
+        size_t last = std::upper_bound(ranks.begin() + first, ranks.end(), pos) - ranks.begin();
+        selectMany(node->left, offset, ranks.first(first), out);
+        std::fill(out + first, out + last, node->value);
+        selectMany(node->right, pos + 1, ranks.subspan(last), out + last);
+    }
+
+    // Вершина с номером k или nullptr, если k == size().
+    Node* nodeAt(size_t k) const {
+        Node* current = root;
+        while (current) {
+            size_t left_size = getSize(current->left);
+            if (k == left_size) {
+                break;
+            }
+            if (k < left_size) {
+                current = current->left;
+            } else {
+                k -= left_size + 1;
+                current = current->right;
+            }
+        }
+        return current;
+    }
+
+    struct Subtree {
+        Node* root;
+        size_t height;
+    };
+
+    // Поддеревья меньше этого размера обрабатываются в текущем потоке.
+    static constexpr size_t kParallelGrain = 1 << 14;
+
+    // Вершины, выброшенные при слиянии, собираются в стек через поле parent
+    // (вместе с поддеревьями) и освобождаются после параллельной части.
+    std::atomic<Node*> dropped_{nullptr};
+
+    template <typename Operation>
+    void combineWith(RBTree&& other, Operation operation) {
+        if (&other == this) {
+            return;
+        }
+        alloc_.adopt(std::move(other.alloc_));
+        Subtree first = {root, blackHeight(root)};
+        Subtree second = {other.root, blackHeight(other.root)};
+        other.root = nullptr;
+        other.size_ = 0;
+
+        size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        size_t depth = 0;
+        while ((size_t{1} << depth) < threads) {
+            ++depth;
+        }
+        root = operation(first, second, depth + 1).root;
+        size_ = getSize(root);
+
+        Node* node = dropped_.exchange(nullptr);
+        while (node) {
+            Node* next = node->parent;
+            destroySubtree(node);
+            node = next;
+        }
+    }
+
+    void drop(Node* node) {
         if (!node) {
             return;
         }
-        deleteNode(node->left);
-        deleteNode(node->right);
-        delete node;
+        node->parent = dropped_.load(std::memory_order_relaxed);
+        while (!dropped_.compare_exchange_weak(node->parent, node, std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+        }
     }
 
-    void insertNode(Node<ValueType>* current, ValueType value) {
-        if (!current || value == current->value) {
+    void destroySubtree(Node* node) {
+        if (!node) {
             return;
         }
-        if (current->value < value) {
+        destroySubtree(node->left);
+        destroySubtree(node->right);
+        alloc_.destroy(node);
+    }
+
+    // Считает две ветви рекурсии, при parallel вторая уходит в отдельный поток.
+    template <typename First, typename Second>
+    static std::pair<Subtree, Subtree> fork(bool parallel, First first, Second second) {
+        if (!parallel) {
+            Subtree res = first();
+            return {res, second()};
+        }
+        auto future = std::async(std::launch::async, second);
+        Subtree res = first();
+        return {res, future.get()};
+    }
+
+    // depth — сколько ещё раз можно раздвоиться по пути вниз, так что потоков не
+    // больше 2^depth.
+    static bool worthForking(Subtree first, Subtree second, size_t depth) {
+        return depth > 0 && getSize(first.root) + getSize(second.root) >= kParallelGrain;
+    }
+
+    Subtree unite(Subtree first, Subtree second, size_t depth) {
+        if (!first.root) {
+            return second;
+        }
+        if (!second.root) {
+            return first;
+        }
+        Node* mid = first.root;
+        Subtree left = detach(mid->left, first.height - 1);
+        Subtree right = detach(mid->right, first.height - 1);
+        auto [less, same, greater] = splitTree(second, mid->value);
+        drop(same);
+        bool parallel = worthForking(first, second, depth);
+        size_t next = parallel ? depth - 1 : depth;
+        auto [res_left, res_right] = fork(
+            parallel, [&, less = less] { return unite(left, less, next); },
+            [&, greater = greater] { return unite(right, greater, next); });
+        return joinTrees(res_left, mid, res_right);
+    }
+
+    Subtree intersect(Subtree first, Subtree second, size_t depth) {
+        if (!first.root || !second.root) {
+            drop(first.root);
+            drop(second.root);
+            return {nullptr, 0};
+        }
+        Node* mid = first.root;
+        Subtree left = detach(mid->left, first.height - 1);
+        Subtree right = detach(mid->right, first.height - 1);
+        auto [less, same, greater] = splitTree(second, mid->value);
+        bool parallel = worthForking(first, second, depth);
+        size_t next = parallel ? depth - 1 : depth;
+        auto [res_left, res_right] = fork(
+            parallel, [&, less = less] { return intersect(left, less, next); },
+            [&, greater = greater] { return intersect(right, greater, next); });
+        if (!same) {
+            mid->left = mid->right = nullptr;
+            drop(mid);
+            return joinPair(res_left, res_right);
+        }
+        drop(same);
+        return joinTrees(res_left, mid, res_right);
+    }
+
+    Subtree subtract(Subtree first, Subtree second, size_t depth) {
+        if (!first.root || !second.root) {
+            drop(second.root);
+            return first;
+        }
+        Node* mid = first.root;
+        Subtree left = detach(mid->left, first.height - 1);
+        Subtree right = detach(mid->right, first.height - 1);
+        auto [less, same, greater] = splitTree(second, mid->value);
+        bool parallel = worthForking(first, second, depth);
+        size_t next = parallel ? depth - 1 : depth;
+        auto [res_left, res_right] = fork(
+            parallel, [&, less = less] { return subtract(left, less, next); },
+            [&, greater = greater] { return subtract(right, greater, next); });
+        if (same) {
+            drop(same);
+            mid->left = mid->right = nullptr;
+            drop(mid);
+            return joinPair(res_left, res_right);
+        }
+        return joinTrees(res_left, mid, res_right);
+    }
+
+    static size_t blackHeight(const Node* node) {
+        size_t height = 0;
+        for (; node; node = node->left) {
+            if (node->color == Color::BLACK) {
+                ++height;
+            }
+        }
+        return height;
+    }
+
+    static Subtree detach(Node* node, size_t height) {
+        if (!node) {
+            return {nullptr, 0};
+        }
+        node->parent = nullptr;
+        if (node->color == Color::RED) {
+            node->color = Color::BLACK;
+            ++height;
+        }
+        return {node, height};
+    }
+
+    // Делит дерево на элементы меньше value, вершину с value (если есть) и большие.
+    static std::tuple<Subtree, Node*, Subtree> splitTree(Subtree tree, const ValueType& value) {
+        Node* node = tree.root;
+        if (!node) {
+            return {{nullptr, 0}, nullptr, {nullptr, 0}};
+        }
+        Subtree left = detach(node->left, tree.height - 1);
+        Subtree right = detach(node->right, tree.height - 1);
+        auto order = threeWay(node->value, value);
+        if (order == 0) {
+            node->left = node->right = nullptr;
+            return {left, node, right};
+        }
+        if (order < 0) {
+            auto [less, same, greater] = splitTree(right, value);
+            return {joinTrees(left, node, less), same, greater};
+        }
+        auto [less, same, greater] = splitTree(left, value);
+        return {less, same, joinTrees(greater, node, right)};
+    }
+
+    // Делит дерево на k наименьших элементов и остальные.
+    static std::pair<Subtree, Subtree> splitRank(Subtree tree, size_t k) {
+        Node* node = tree.root;
+        if (!node) {
+            return {{nullptr, 0}, {nullptr, 0}};
+        }
+        Subtree left = detach(node->left, tree.height - 1);
+        Subtree right = detach(node->right, tree.height - 1);
+        size_t left_size = getSize(left.root);
+        if (k <= left_size) {
+            auto [less, rest] = splitRank(left, k);
+            return {less, joinTrees(rest, node, right)};
+        }
+        auto [less, rest] = splitRank(right, k - left_size - 1);
+        return {joinTrees(left, node, less), rest};
+    }
+
+    // Отрезает наибольшую вершину дерева.
+    static std::pair<Subtree, Node*> splitLast(Subtree tree) {
+        Node* node = tree.root;
+        Subtree left = detach(node->left, tree.height - 1);
+        Subtree right = detach(node->right, tree.height - 1);
+        if (!right.root) {
+            return {left, node};
+        }
+        auto [rest, last] = splitLast(right);
+        return {joinTrees(left, node, rest), last};
+    }
+
+    // Склеивает деревья left < right без разделяющей вершины.
+    static Subtree joinPair(Subtree left, Subtree right) {
+        if (!left.root) {
+            return right;
+        }
+        if (!right.root) {
+            return left;
+        }
+        auto [rest, last] = splitLast(left);
+        return joinTrees(rest, last, right);
+    }
+
+    // Склеивает деревья left < mid < right: mid подвешивается на правый (левый) край
+    // более высокого дерева на уровне с чёрной высотой низкого, размеры и свёртки
+    // пересчитываются вверх по краю, затем как при вставке устраняется
+    // красно-красный конфликт.
+    static Subtree joinTrees(Subtree left, Node* mid, Subtree right) {
+        mid->parent = nullptr;
+        if (left.height == right.height) {
+            mid->left = left.root;
+            mid->right = right.root;
+            if (left.root) {
+                left.root->parent = mid;
+            }
+            if (right.root) {
+                right.root->parent = mid;
+            }
+            mid->color = Color::BLACK;
+            pull(mid);
+            return {mid, left.height + 1};
+        }
+
+        bool left_is_higher = left.height > right.height;
+        Subtree high = left_is_higher ? left : right;
+        size_t target = left_is_higher ? right.height : left.height;
+        Node* pa = nullptr;
+        Node* current = high.root;
+        size_t height = high.height;
+        while (current && !(current->color == Color::BLACK && height == target)) {
+            if (current->color == Color::BLACK) {
+                --height;
+            }
+            pa = current;
+            current = left_is_higher ? current->right : current->left;
+        }
+
+        Node* low = left_is_higher ? right.root : left.root;
+        mid->left = left_is_higher ? current : low;
+        mid->right = left_is_higher ? low : current;
+        if (current) {
+            current->parent = mid;
+        }
+        if (low) {
+            low->parent = mid;
+        }
+        mid->parent = pa;
+        if (left_is_higher) {
+            pa->right = mid;
+        } else {
+            pa->left = mid;
+        }
+        mid->color = Color::RED;
+        for (Node* node = mid; node; node = node->parent) {
+            pull(node);
+        }
+        Node* top = high.root;
+        bool grew = balance(mid, top);
+        return {top, high.height + (grew ? 1 : 0)};
+    }
+
+    void destroyNodes(Node* node) {
+        if (!node) {
+            return;
+        }
+        destroyNodes(node->left);
+        destroyNodes(node->right);
+        std::destroy_at(node);
+    }
+
+    void insertNode(Node* current, ValueType value) {
+        if (!current) {
+            return;
+        }
+        auto order = threeWay(current->value, value);
+        if (order == 0) {
+            return;
+        }
+        if (order < 0) {
             if (current->right) {
                 insertNode(current->right, value);
             } else {
-                Node<ValueType>* new_node = new Node<ValueType>(value, current);
+                Node* new_node = alloc_.create(value, current);
                 current->right = new_node;
                 updateSize(current->right);
-                balance(new_node);
+                balance(new_node, root);
                 ++size_;
             }
         } else {
             if (current->left) {
                 insertNode(current->left, value);
             } else {
-                Node<ValueType>* new_node = new Node<ValueType>(value, current);
+                Node* new_node = alloc_.create(value, current);
                 current->left = new_node;
                 updateSize(current->left);
-                balance(new_node);
+                balance(new_node, root);
                 ++size_;
             }
         }
     }
 
-    void rightRotation(Node<ValueType>* pivot) {
-        Node<ValueType>* node = pivot->left;
-        pivot->sub_size = pivot->sub_size - node->sub_size + getSize(node->right);
-        node->sub_size = node->sub_size - getSize(node->right) + pivot->sub_size;
+    // Повороты и балансировка работают с поддеревом, корень которого хранится в top:
+    // так их можно вызывать для отдельных деревьев при split и join.
+    static void rightRotation(Node* pivot, Node*& top) {
+        Node* node = pivot->left;
         if (pivot->parent) {
             if (pivot->parent->right == pivot) {
                 pivot->parent->right = node;
@@ -298,7 +962,7 @@ private:
             }
             node->parent = pivot->parent;
         } else {
-            root = node;
+            top = node;
             node->parent = nullptr;
         }
         pivot->left = node->right;
@@ -307,12 +971,12 @@ private:
         }
         pivot->parent = node;
         node->right = pivot;
+        pull(pivot);
+        pull(node);
     }
 
-    void leftRotation(Node<ValueType>* pivot) {
-        Node<ValueType>* node = pivot->right;
-        pivot->sub_size = pivot->sub_size - node->sub_size + getSize(node->left);
-        node->sub_size = node->sub_size - getSize(node->left) + pivot->sub_size;
+    static void leftRotation(Node* pivot, Node*& top) {
+        Node* node = pivot->right;
         if (pivot->parent) {
             if (pivot->parent->right == pivot) {
                 pivot->parent->right = node;
@@ -321,7 +985,7 @@ private:
             }
             node->parent = pivot->parent;
         } else {
-            root = node;
+            top = node;
             node->parent = nullptr;
         }
         pivot->right = node->left;
@@ -330,59 +994,64 @@ private:
         }
         pivot->parent = node;
         node->left = pivot;
+        pull(pivot);
+        pull(node);
     }
 
-    void balance(Node<ValueType>* son) {
+    // Возвращает true, если перекраска корня увеличила чёрную высоту.
+    static bool balance(Node* son, Node*& top) {
         // Случай 3: корень красный.
-        if (son == root) {
+        if (son == top) {
+            bool grew = son->color == Color::RED;
             son->color = Color::BLACK;
-            return;
+            return grew;
         }
-        if (son->parent == root) {
+        if (son->parent == top) {
             son->parent->color = Color::BLACK;
-            return;
+            return false;
         }
         if (son->color == Color::BLACK || son->parent->color == Color::BLACK) {
-            return;
+            return false;
         }
 
-        Node<ValueType>* pa = son->parent;
-        Node<ValueType>* grandpa = pa->parent;
-        Node<ValueType>* uncle = pa == grandpa->right ? grandpa->left : grandpa->right;
+        Node* pa = son->parent;
+        Node* grandpa = pa->parent;
+        Node* uncle = pa == grandpa->right ? grandpa->left : grandpa->right;
 
         // Случай 1 (и 2): дядя красный.
         if (uncle && uncle->color == Color::RED) {
             pa->color = Color::BLACK;
             uncle->color = Color::BLACK;
             grandpa->color = Color::RED;
-            balance(grandpa);
+            return balance(grandpa, top);
         } else {
             // Случай 4 (и 5): дядя чёрный или его нет.
             if (grandpa->left == pa) {
                 if (pa->right == son) {
-                    leftRotation(pa);
+                    leftRotation(pa, top);
                     std::swap(pa, son);
                 }
-                rightRotation(grandpa);
+                rightRotation(grandpa, top);
             } else {
                 if (pa->left == son) {
-                    rightRotation(pa);
+                    rightRotation(pa, top);
                     std::swap(pa, son);
                 }
-                leftRotation(grandpa);
+                leftRotation(grandpa, top);
             }
             grandpa->color = Color::RED;
             pa->color = Color::BLACK;
         }
+        return false;
     }
 
-    void copyChildren(Node<ValueType>* new_current, Node<ValueType>* current) {
+    void copyChildren(Node* new_current, Node* current) {
         if (!new_current) {
             return;
         }
 
         if (current->left) {
-            new_current->left = new Node<ValueType>(current->left->value, new_current);
+            new_current->left = alloc_.create(current->left->value, new_current);
             new_current->left->color = current->left->color;
             copyChildren(new_current->left, current->left);
         } else {
@@ -390,7 +1059,7 @@ private:
         }
 
         if (current->right) {
-            new_current->right = new Node<ValueType>(current->right->value, new_current);
+            new_current->right = alloc_.create(current->right->value, new_current);
             new_current->right->color = current->right->color;
             copyChildren(new_current->right, current->right);
         } else {
@@ -398,15 +1067,62 @@ private:
         }
     }
 
-    void updateSize(Node<ValueType>* node) {
-        if (!node) {
-            return;
+    // Пересчитывает размер и свёртку вершины по её детям.
+    static void pull(Node* node) {
+        node->sub_size = getSize(node->left) + getSize(node->right) + 1;
+        if constexpr (!std::is_empty_v<Summary>) {
+            node->summary = Augment::combine(
+                Augment::combine(getSummary(node->left), Augment::lift(node->value)),
+                getSummary(node->right));
+        }
+    }
+
+    // Пересчитывает вершины на пути от node до корня.
+    void updateSize(Node* node) {
+        for (; node; node = node->parent) {
+            pull(node);
         }
-        node->sub_size = getSize(node->right) + getSize(node->left) + 1;
-        updateSize(node->parent);
     }
 
-    size_t getSize(Node<ValueType>* node) const {
+    static bool less(const ValueType& first, const ValueType& second) {
+        return threeWay(first, second) < 0;
+    }
+
+    // Свёртка элементов поддерева, не меньших lo.
+    Summary suffixFrom(Node* node, const ValueType& lo) const {
+        Summary res = Augment::identity();
+        while (node) {
+            if (less(node->value, lo)) {
+                node = node->right;
+            } else {
+                res = Augment::combine(
+                    Augment::combine(Augment::lift(node->value), getSummary(node->right)), res);
+                node = node->left;
+            }
+        }
+        return res;
+    }
+
+    // Свёртка элементов поддерева, меньших hi.
+    Summary prefixBelow(Node* node, const ValueType& hi) const {
+        Summary res = Augment::identity();
+        while (node) {
+            if (less(node->value, hi)) {
+                res = Augment::combine(
+                    res, Augment::combine(getSummary(node->left), Augment::lift(node->value)));
+                node = node->right;
+            } else {
+                node = node->left;
+            }
+        }
+        return res;
+    }
+
+    static Summary getSummary(Node* node) {
+        return node ? node->summary : Augment::identity();
+    }
+
+    static size_t getSize(Node* node) {
         return node ? node->sub_size : 0;
     }
 };
@@ -11,25 +11,19 @@ constexpr bool operator==(const ValueType& first, const ValueType& second) {
 
 template <typename K, typename V>
 struct Node {
-    K key;
-    V value;
+    std::pair<const K, V> data;
     Node<K, V>* left;
     Node<K, V>* right;
     Node<K, V>* parent;
     Color color;
 
-    Node() : key(), value(), left(nullptr), right(nullptr), parent(nullptr), color(Color::RED) {
+    Node() : data(), left(nullptr), right(nullptr), parent(nullptr), color(Color::RED) {
     }
     explicit Node(const K& key, const V& value)
-        : key(key),
-          value(value),
-          left(nullptr),
-          right(nullptr),
-          parent(nullptr),
-          color(Color::RED) {
+        : data(key, value), left(nullptr), right(nullptr), parent(nullptr), color(Color::RED) {
     }
-    Node(K key, V value, Node<K, V>* pa)
-        : key(key), value(value), left(nullptr), right(nullptr), parent(pa), color(Color::RED) {
+    Node(const K& key, const V& value, Node<K, V>* pa)
+        : data(key, value), left(nullptr), right(nullptr), parent(pa), color(Color::RED) {
     }
 };
 
@@ -44,14 +38,14 @@ public:
         Iterator(Node<K, V>* node, Node<K, V>* root) : current_(node), root_(root) {
         }
 
-        const std::pair<K, V>& operator*() const {
-            return *new std::pair<K, V>(current_->key, current_->value);
+        const std::pair<const K, V>& operator*() const {
+            return current_->data;
         }
-        const std::pair<K, V>* operator->() const {
+        const std::pair<const K, V>* operator->() const {
             if (!current_) {
                 return nullptr;
             }
-            return new std::pair<K, V>(current_->key, current_->value);
+            return &current_->data;
         }
 
         Iterator& operator++() {
@@ -158,7 +152,7 @@ public:
             size_ = 0;
             return;
         }
-        root = new Node<K, V>(other.root->key, other.root->value);
+        root = new Node<K, V>(other.root->data.first, other.root->data.second);
         root->color = Color::BLACK;
         size_ = other.size_;
         copyChildren(root, other.root);
@@ -170,7 +164,7 @@ public:
             size_ = 0;
             return *this;
         }
-        root = new Node<K, V>(other.root->key, other.root->value);
+        root = new Node<K, V>(other.root->data.first, other.root->data.second);
         root->color = Color::BLACK;
         size_ = other.size_;
         copyChildren(root, other.root);
@@ -198,32 +192,28 @@ public:
             return;
         }
 
+        // Вершина с двумя потомками: ключ константный, поэтому переставляем саму вершину.
+        if (to_del->right && to_del->left) {
+            swapWithPredecessor(to_del, Iterator::mostRight(to_del->left));
+        }
         // Это лист.
         if (!to_del->right && !to_del->left) {
             delLeaf(to_del);
-            // Вершина с двумя потомками.
-        } else if (to_del->right && to_del->left) {
-            Node<K, V>* ios = Iterator::mostRight(to_del->left);
-            std::swap(ios->key, to_del->key);
-            std::swap(ios->value, to_del->value);
-            delLeaf(ios);
             // Чёрная вершина с одним потомком.
         } else {
-            // Только правый ребёнок.
-            if (to_del->right) {
-                std::swap(to_del->key, to_del->right->key);
-                std::swap(to_del->value, to_del->right->value);
-                delLeaf(to_del->right);
-                // Только левый ребёнок.
-            } else {
-                std::swap(to_del->key, to_del->left->key);
-                std::swap(to_del->value, to_del->left->value);
-                delLeaf(to_del->left);
-            }
+            delOnlyChild(to_del);
         }
         --size_;
     }
 
+    void delOnlyChild(Node<K, V>* to_del) {
+        // Единственный ребёнок обязательно красный лист.
+        Node<K, V>* child = to_del->right ? to_del->right : to_del->left;
+        replaceInParent(to_del, child);
+        child->color = Color::BLACK;
+        delete to_del;
+    }
+
     size_t size() const {
         return size_;
     }
@@ -242,7 +232,7 @@ public:
         if (current == nullptr) {
             return res;
         }
-        if (current->key < key) {
+        if (current->data.first < key) {
             res = lowerBound(key, current->right, res);
         } else {
             res = lowerBound(key, current->left, current);
@@ -276,11 +266,11 @@ private:
     }
 
     void insertNode(Node<K, V>* current, K key, V value) {
-        if (!current || key == current->key) {
-            current->value = value;
+        if (!current || key == current->data.first) {
+            current->data.second = value;
             return;
         }
-        if (current->key < key) {
+        if (current->data.first < key) {
             if (current->right) {
                 insertNode(current->right, key, value);
             } else {
@@ -301,6 +291,44 @@ private:
         }
     }
 
+    void replaceInParent(Node<K, V>* old_node, Node<K, V>* node) {
+        if (old_node->parent) {
+            if (old_node->parent->right == old_node) {
+                old_node->parent->right = node;
+            } else {
+                old_node->parent->left = node;
+            }
+        } else {
+            root = node;
+        }
+        if (node) {
+            node->parent = old_node->parent;
+        }
+    }
+
+    void swapWithPredecessor(Node<K, V>* node, Node<K, V>* pred) {
+        Node<K, V>* pred_pa = pred->parent;
+        Node<K, V>* pred_left = pred->left;
+        std::swap(node->color, pred->color);
+        replaceInParent(node, pred);
+        pred->right = node->right;
+        pred->right->parent = pred;
+        if (pred_pa == node) {
+            pred->left = node;
+            node->parent = pred;
+        } else {
+            pred->left = node->left;
+            pred->left->parent = pred;
+            pred_pa->right = node;
+            node->parent = pred_pa;
+        }
+        node->left = pred_left;
+        if (pred_left) {
+            pred_left->parent = node;
+        }
+        node->right = nullptr;
+    }
+
     void rightRotation(Node<K, V>* pivot) {
         Node<K, V>* node = pivot->left;
         if (pivot->parent) {
@@ -394,7 +422,7 @@ private:
 
         if (current->left) {
             new_current->left =
-                new Node<K, V>(current->left->key, current->left->value, new_current);
+                new Node<K, V>(current->left->data.first, current->left->data.second, new_current);
             new_current->left->color = current->left->color;
             copyChildren(new_current->left, current->left);
         } else {
@@ -403,7 +431,7 @@ private:
 
         if (current->right) {
             new_current->right =
-                new Node<K, V>(current->right->key, current->right->value, new_current);
+                new Node<K, V>(current->right->data.first, current->right->data.second, new_current);
             new_current->right->color = current->right->color;
             copyChildren(new_current->right, current->right);
         } else {
@@ -512,8 +540,8 @@ private:
 
     Node<K, V>* findNode(const K& key) const {
         Node<K, V>* current = root;
-        while (current && !(current->key == key)) {
-            if (current->key < key) {
+        while (current && !(current->data.first == key)) {
+            if (current->data.first < key) {
                 current = current->right;
             } else {
                 current = current->left;
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Выдаёт вершины деревьев из крупных блоков. Освобождённые вершины попадают
+// в список свободных и переиспользуются, а release() отдаёт все блоки разом,
+// не вызывая деструкторов.
+//
+// Когда вершины переходят в другое дерево (split), блоки оказываются общими, и
+// аллокаторы обоих деревьев переходят на учёт по блокам: в заголовке блока хранится
+// число его ячеек, которые ещё удерживают деревья. Тогда перед release() дерево
+// возвращает свои вершины через destroy(), и каждый блок освобождается, как только
+// его ячейки вернули все деревья. Пока split не было, блоки отдаются целиком.
+template <typename T, size_t BlockSize = 256>
+class SlabAllocator {
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    // Блок выровнен по своему размеру (степени двойки), поэтому заголовок находится
+    // по адресу любой ячейки блока.
+    struct Header {
+        // Выданные вершины, ячейки в списках свободных и ещё не выданный остаток.
+        std::atomic<size_t> held;
+        // Следующий блок в списке собственных блоков необщего аллокатора.
+        Header* next;
+    };
+
+    static constexpr size_t kSlotsOffset =
+        (sizeof(Header) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+    static constexpr size_t kBlockBytes = std::bit_ceil(kSlotsOffset + BlockSize * sizeof(Slot));
+    static constexpr size_t kSlotsPerBlock = (kBlockBytes - kSlotsOffset) / sizeof(Slot);
+
+public:
+    SlabAllocator()
+        : blocks_(nullptr),
+          blocks_tail_(nullptr),
+          shared_(false),
+          free_(nullptr),
+          free_tail_(nullptr),
+          current_(nullptr),
+          next_(nullptr),
+          left_(0) {
+    }
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    SlabAllocator(SlabAllocator&& other) noexcept
+        : blocks_(other.blocks_),
+          blocks_tail_(other.blocks_tail_),
+          shared_(other.shared_),
+          free_(other.free_),
+          free_tail_(other.free_tail_),
+          current_(other.current_),
+          next_(other.next_),
+          left_(other.left_) {
+        other.forget();
+    }
+
+    SlabAllocator& operator=(SlabAllocator&& other) noexcept {
+        std::swap(blocks_, other.blocks_);
+        std::swap(blocks_tail_, other.blocks_tail_);
+        std::swap(shared_, other.shared_);
+        std::swap(free_, other.free_);
+        std::swap(free_tail_, other.free_tail_);
+        std::swap(current_, other.current_);
+        std::swap(next_, other.next_);
+        std::swap(left_, other.left_);
+        return *this;
+    }
+
+    ~SlabAllocator() {
+        release();
+    }
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        Slot* slot = allocate();
+        try {
+            return new (slot->storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            pushFree(slot);
+            throw;
+        }
+    }
+
+    void destroy(T* ptr) {
+        ptr->~T();
+        pushFree(reinterpret_cast<Slot*>(ptr));
+    }
+
+    // Блоки общие с другими деревьями: вершины нужно вернуть через destroy() до release().
+    bool isShared() const {
+        return shared_;
+    }
+
+    // Отдаёт память. Необщий аллокатор освобождает свои блоки целиком, включая ещё не
+    // возвращённые вершины; общий — возвращает в блоки список свободных и остаток
+    // текущего блока.
+    void release() {
+        if (!shared_) {
+            while (blocks_) {
+                Header* next = blocks_->next;
+                freeBlock(blocks_);
+                blocks_ = next;
+            }
+        } else {
+            while (free_) {
+                Slot* next = free_->next;
+                drop(headerOf(free_), 1);
+                free_ = next;
+            }
+            if (left_ > 0) {
+                drop(current_, left_);
+            }
+        }
+        forget();
+    }
+
+    // Пустой аллокатор для вершин, которые уходят в другое дерево. Оба аллокатора
+    // после этого ведут учёт по блокам.
+    SlabAllocator sibling() {
+        makeShared();
+        SlabAllocator res;
+        res.shared_ = true;
+        return res;
+    }
+
+    // Забирает блоки и свободные ячейки other, other остаётся пустым. Невыданный остаток
+    // текущего блока other (не больше одного блока) уходит в список свободных.
+    void adopt(SlabAllocator&& other) {
+        if (&other == this) {
+            return;
+        }
+        if (other.shared_) {
+            makeShared();
+        } else if (!shared_ && other.blocks_) {
+            if (blocks_tail_) {
+                blocks_tail_->next = other.blocks_;
+            } else {
+                blocks_ = other.blocks_;
+            }
+            blocks_tail_ = other.blocks_tail_;
+        }
+        for (; other.left_ > 0; --other.left_) {
+            pushFree(other.next_++);
+        }
+        if (other.free_) {
+            other.free_tail_->next = free_;
+            if (!free_) {
+                free_tail_ = other.free_tail_;
+            }
+            free_ = other.free_;
+        }
+        other.forget();
+    }
+
+private:
+    static Header* headerOf(Slot* slot) {
+        return reinterpret_cast<Header*>(reinterpret_cast<uintptr_t>(slot) & ~(kBlockBytes - 1));
+    }
+
+    static Slot* slotsOf(Header* header) {
+        return reinterpret_cast<Slot*>(reinterpret_cast<unsigned char*>(header) + kSlotsOffset);
+    }
+
+    static void freeBlock(Header* header) {
+        header->~Header();
+        ::operator delete(header, std::align_val_t(kBlockBytes));
+    }
+
+    // Ячейки блока, которые вернул этот аллокатор; последний вернувший освобождает блок.
+    static void drop(Header* header, size_t count) {
+        if (header->held.fetch_sub(count, std::memory_order_acq_rel) == count) {
+            freeBlock(header);
+        }
+    }
+
+    void makeShared() {
+        shared_ = true;
+        blocks_ = nullptr;
+        blocks_tail_ = nullptr;
+    }
+
+    // Забывает всё без освобождения: память теперь принадлежит другому аллокатору.
+    void forget() {
+        blocks_ = nullptr;
+        blocks_tail_ = nullptr;
+        shared_ = false;
+        free_ = nullptr;
+        free_tail_ = nullptr;
+        current_ = nullptr;
+        next_ = nullptr;
+        left_ = 0;
+    }
+
+    Slot* allocate() {
+        if (free_) {
+            Slot* slot = free_;
+            free_ = slot->next;
+            if (!free_) {
+                free_tail_ = nullptr;
+            }
+            return slot;
+        }
+        if (left_ == 0) {
+            addBlock();
+        }
+        --left_;
+        return next_++;
+    }
+
+    void addBlock() {
+        void* raw = ::operator new(kBlockBytes, std::align_val_t(kBlockBytes));
+        Header* header = new (raw) Header{{kSlotsPerBlock}, nullptr};
+        if (!shared_) {
+            if (blocks_tail_) {
+                blocks_tail_->next = header;
+            } else {
+                blocks_ = header;
+            }
+            blocks_tail_ = header;
+        }
+        current_ = header;
+        next_ = slotsOf(header);
+        left_ = kSlotsPerBlock;
+    }
+
+    void pushFree(Slot* slot) {
+        slot->next = free_;
+        if (!free_) {
+            free_tail_ = slot;
+        }
+        free_ = slot;
+    }
+
+    // Собственные блоки, пока аллокатор не общий.
+    Header* blocks_;
+    Header* blocks_tail_;
+    bool shared_;
+    Slot* free_;
+    Slot* free_tail_;
+    Header* current_;
+    Slot* next_;
+    size_t left_;
+};
@@ -0,0 +1,68 @@
+#include <iterator>
+#include <random>
+#include <set>
+
+#include "avl_tree.cpp"
+#include "tests/check.h"
+
+static void checkSame(AVLTree& tree, const std::set<int>& ref) {
+    tree.audit();
+    CHECK(static_cast<size_t>(tree.getSize()) == ref.size());
+    int* values = tree.traversal();
+    size_t i = 0;
+    for (int value : ref) {
+        CHECK(values[i++] == value);
+    }
+    delete[] values;
+}
+
+// Диапазоны от очень узких (почти каждая операция попадает в существующий ключ)
+// до широких; audit() после удалений ловит устаревшие высоты и балансы, которые
+// оставляет ранняя остановка подъёма.
+int main() {
+    for (unsigned seed = 0; seed < 30; ++seed) {
+        std::mt19937 rng(seed);
+        AVLTree tree;
+        std::set<int> ref;
+        int range = 10 + static_cast<int>(seed) * 50;
+        for (int step = 0; step < 20000; ++step) {
+            int value = static_cast<int>(rng() % range);
+            if (rng() % 2) {
+                tree.insert(value);
+                ref.insert(value);
+            } else {
+                tree.erase(value);
+                ref.erase(value);
+            }
+            if (step % 97 == 0) {
+                tree.audit();
+            }
+        }
+        checkSame(tree, ref);
+        for (int value = 0; value < range; ++value) {
+            CHECK((tree.find(value) != nullptr) == (ref.count(value) > 0));
+        }
+        while (!ref.empty()) {
+            auto it = ref.begin();
+            std::advance(it, rng() % ref.size());
+            tree.erase(*it);
+            ref.erase(it);
+            if (ref.size() % 16 == 0) {
+                tree.audit();
+            }
+        }
+        CHECK(tree.empty());
+    }
+
+    // Большое дерево: вставка и удаление без рекурсии.
+    AVLTree big;
+    for (int i = 0; i < 200000; ++i) {
+        big.insert(i);
+    }
+    for (int i = 0; i < 200000; i += 2) {
+        big.erase(i);
+    }
+    big.audit();
+    CHECK(big.getSize() == 100000);
+    std::puts("ok");
+}
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "avl_tree.cpp"
+#include "tests/check.h"
+
+// Итераторы, forEach и copyRange сверяются с диапазонами std::set, включая пустые,
+// перевёрнутые и выходящие за края ключей границы.
+int main() {
+    for (unsigned seed = 0; seed < 20; ++seed) {
+        std::mt19937 rng(seed);
+        AVLTree tree;
+        std::set<int> ref;
+        int range = 5 + static_cast<int>(seed) * 100;
+        for (int step = 0; step < 5000; ++step) {
+            int value = static_cast<int>(rng() % range);
+            if (rng() % 3) {
+                tree.insert(value);
+                ref.insert(value);
+            } else {
+                tree.erase(value);
+                ref.erase(value);
+            }
+        }
+        std::vector<int> forward(tree.begin(), tree.end());
+        CHECK(std::equal(forward.begin(), forward.end(), ref.begin(), ref.end()));
+        std::vector<int> backward;
+        for (auto it = tree.end(); it != tree.begin();) {
+            backward.push_back(*--it);
+        }
+        CHECK(std::equal(backward.begin(), backward.end(), ref.rbegin(), ref.rend()));
+
+        for (int query = 0; query < 300; ++query) {
+            int lo = static_cast<int>(rng() % (range + 20)) - 10;
+            int hi = lo + static_cast<int>(rng() % (range / 2 + 3)) - 2;
+            std::vector<int> expected;
+            for (auto it = ref.lower_bound(lo); it != ref.end() && *it < hi; ++it) {
+                expected.push_back(*it);
+            }
+            std::vector<int> visited;
+            tree.forEach(lo, hi, [&visited](int value) { visited.push_back(value); });
+            CHECK(visited == expected);
+            std::vector<int> buffer(rng() % (expected.size() + 3));
+            size_t copied = tree.copyRange(lo, hi, buffer);
+            CHECK(copied == std::min(buffer.size(), expected.size()));
+            CHECK(std::equal(buffer.begin(), buffer.begin() + copied, expected.begin()));
+        }
+    }
+    AVLTree empty;
+    CHECK(empty.begin() == empty.end());
+    std::vector<int> buffer(4);
+    CHECK(empty.copyRange(0, 10, buffer) == 0);
+    std::puts("ok");
+}
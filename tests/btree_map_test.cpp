@@ -0,0 +1,85 @@
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "btree_map.cpp"
+#include "tests/check.h"
+
+template <typename M, typename K, typename V>
+void checkSame(const M& m, const std::map<K, V>& ref) {
+    CHECK(m.size() == ref.size());
+    auto it = ref.begin();
+    for (const auto& [key, value] : m) {
+        CHECK(it != ref.end() && key == it->first && value == it->second);
+        ++it;
+    }
+    CHECK(it == ref.end());
+    auto back = m.end();
+    for (auto rit = ref.rbegin(); rit != ref.rend(); ++rit) {
+        --back;
+        CHECK(back->first == rit->first);
+    }
+}
+
+// Строки в ключах и значениях проверяют, что при сдвигах, разбиениях и слияниях листов
+// элементы переносятся конструкторами, а не побайтово: ошибки ловит AddressSanitizer.
+template <typename K, typename V, typename MakeKey, typename MakeValue>
+void runRandom(int range, int steps, MakeKey make_key, MakeValue make_value) {
+    std::mt19937 rng(range);
+    BTreeMap<K, V> m;
+    std::map<K, V> ref;
+    for (int step = 0; step < steps; ++step) {
+        K key = make_key(static_cast<int>(rng() % range));
+        switch (rng() % 5) {
+            case 0:
+            case 1:
+                m.insert(key, make_value(step));
+                ref[key] = make_value(step);
+                break;
+            case 2:
+            case 3:
+                m.erase(key);
+                ref.erase(key);
+                break;
+            default: {
+                auto lower = m.lowerBound(key);
+                auto ref_lower = ref.lower_bound(key);
+                CHECK((lower == m.end()) == (ref_lower == ref.end()));
+                CHECK(lower == m.end() || lower->first == ref_lower->first);
+                CHECK((m.find(key) == m.end()) == (ref.find(key) == ref.end()));
+            }
+        }
+        if (step % 20000 == 0) {
+            checkSame(m, ref);
+        }
+    }
+    checkSame(m, ref);
+    BTreeMap<K, V> copy(m);
+    checkSame(copy, ref);
+    copy = m;
+    checkSame(copy, ref);
+    for (const auto& entry : ref) {
+        m.erase(entry.first);
+    }
+    CHECK(m.empty() && m.begin() == m.end());
+}
+
+int main() {
+    auto int_key = [](int k) { return k; };
+    auto int_value = [](int v) { return v; };
+    auto string_key = [](int k) { return std::to_string(k); };
+    auto string_value = [](int v) { return std::string(20, static_cast<char>('a' + v % 26)); };
+    for (int range : {50, 3000, 100000}) {
+        runRandom<int, int>(range, 200000, int_key, int_value);
+        runRandom<std::string, std::string>(range, 50000, string_key, string_value);
+    }
+
+    BTreeMap<std::string, int, std::less<>> transparent;
+    transparent.insert("alpha", 1);
+    transparent.insert("beta", 2);
+    CHECK(transparent.find(std::string_view("beta"))->second == 2);
+    transparent.erase(std::string_view("alpha"));
+    CHECK(transparent.size() == 1 && transparent.begin()->first == "beta");
+    std::puts("ok");
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Общее для тестов в tests/. Каждый тест — отдельная программа, которая сверяет
+// контейнер с std::map или std::set на случайных операциях. Сборка из корня репозитория:
+//   g++ -std=c++20 -O1 -g -fsanitize=address,undefined -I. tests/<name>.cpp -o <name>
+// Тест печатает "ok" и возвращает 0; при первой ошибке печатает условие и падает.
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            std::abort();                                                            \
+        }                                                                            \
+    } while (false)
@@ -0,0 +1,69 @@
+#include <random>
+#include <set>
+#include <string>
+
+#include "compact_rb_tree.h"
+#include "tests/check.h"
+
+template <typename T>
+static void checkSame(const CompactRBTree<T>& tree, const std::set<T>& ref) {
+    CHECK(tree.size() == ref.size());
+    auto it = ref.begin();
+    for (const T& value : tree) {
+        CHECK(it != ref.end() && value == *it);
+        ++it;
+    }
+    CHECK(it == ref.end());
+    if (!ref.empty()) {
+        auto last = tree.end();
+        --last;
+        CHECK(*last == *ref.rbegin());
+    }
+}
+
+// Удаление переносит последнюю вершину массива в освободившийся слот, поэтому
+// удаления вперемешку со вставками проверяют и перенумерацию ссылок на неё.
+int main() {
+    std::mt19937 rng(8);
+    CompactRBTree<int> tree{3, 1, 2};
+    std::set<int> ref{1, 2, 3};
+    for (int step = 0; step < 300000; ++step) {
+        int value = static_cast<int>(rng() % 4000);
+        if (rng() % 2) {
+            tree.insert(value);
+            ref.insert(value);
+        } else {
+            tree.erase(value);
+            ref.erase(value);
+        }
+        if (step % 997 == 0) {
+            checkSame(tree, ref);
+            int query = static_cast<int>(rng() % 4000);
+            auto lower = tree.lowerBound(query);
+            auto ref_lower = ref.lower_bound(query);
+            CHECK(ref_lower == ref.end() ? lower == tree.end() : *lower == *ref_lower);
+            CHECK((tree.find(query) != tree.end()) == (ref.count(query) > 0));
+        }
+    }
+    CompactRBTree<int> copy(tree);
+    checkSame(copy, ref);
+    while (!ref.empty()) {
+        tree.erase(*ref.begin());
+        ref.erase(ref.begin());
+    }
+    checkSame(tree, ref);
+    CHECK(tree.begin() == tree.end());
+
+    CompactRBTree<std::string> strings;
+    std::set<std::string> ref_strings;
+    for (int i = 0; i < 1000; ++i) {
+        strings.insert(std::to_string(i));
+        ref_strings.insert(std::to_string(i));
+    }
+    for (int i = 0; i < 1000; i += 3) {
+        strings.erase(std::to_string(i));
+        ref_strings.erase(std::to_string(i));
+    }
+    checkSame(strings, ref_strings);
+    std::puts("ok");
+}
@@ -0,0 +1,104 @@
+#include <atomic>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "concurrent_map.cpp"
+#include "tests/check.h"
+
+// Писатели меняют непересекающиеся множества ключей (ключ по модулю числа писателей),
+// разбросанные по всем шардам, и ведут каждый свой последовательный эталон. Читатели
+// параллельно проверяют то, что не зависит от чередования: значение принадлежит своему
+// ключу, версии ключа не убывают, forEach выдаёт возрастающие ключи из диапазона.
+// В конце словарь должен совпасть с объединением эталонов. Тест рассчитан и на
+// -fsanitize=thread.
+
+constexpr int kWriters = 4;
+constexpr int kReaders = 3;
+constexpr long long kKeys = 4000;
+constexpr int kOps = 20000;
+
+// Значение кодирует ключ и номер записи: version * kKeys + key.
+long long encode(int key, int version) {
+    return static_cast<long long>(version) * kKeys + key;
+}
+
+int main() {
+    std::vector<int> boundaries;
+    for (int bound = 250; bound < kKeys; bound += 250) {
+        boundaries.push_back(bound);
+    }
+    ConcurrentMap<int, long long> m(boundaries);
+    std::vector<std::map<int, long long>> refs(kWriters);
+    std::atomic<int> writers_left = kWriters;
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < kWriters; ++w) {
+        threads.emplace_back([&, w] {
+            std::mt19937 rng(w);
+            auto& ref = refs[w];
+            for (int op = 1; op <= kOps; ++op) {
+                int key = static_cast<int>(rng() % (kKeys / kWriters)) * kWriters + w;
+                if (rng() % 3) {
+                    m.insert(key, encode(key, op));
+                    ref[key] = encode(key, op);
+                } else {
+                    m.erase(key);
+                    ref.erase(key);
+                }
+            }
+            --writers_left;
+        });
+    }
+    for (int r = 0; r < kReaders; ++r) {
+        threads.emplace_back([&, r] {
+            std::mt19937 rng(100 + r);
+            std::vector<long long> last_seen(kKeys, -1);
+            do {
+                int key = static_cast<int>(rng() % kKeys);
+                if (auto value = m.find(key)) {
+                    CHECK(*value % kKeys == key);
+                    CHECK(*value >= last_seen[key]);
+                    last_seen[key] = *value;
+                }
+                m.contains(key);
+
+                int lo = static_cast<int>(rng() % kKeys);
+                int hi = lo + static_cast<int>(rng() % 600);
+                int prev = lo - 1;
+                m.forEach(lo, hi, [&](int k, long long value) {
+                    CHECK(k > prev && k < hi);
+                    CHECK(value % kKeys == k);
+                    prev = k;
+                });
+                CHECK(m.size() <= static_cast<size_t>(kKeys));
+            } while (writers_left > 0);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::map<int, long long> ref;
+    for (const auto& part : refs) {
+        ref.insert(part.begin(), part.end());
+    }
+    CHECK(m.size() == ref.size());
+    auto it = ref.begin();
+    m.forEach(-1, static_cast<int>(kKeys), [&](int key, long long value) {
+        CHECK(it != ref.end() && key == it->first && value == it->second);
+        ++it;
+    });
+    CHECK(it == ref.end());
+    for (int key = 0; key < kKeys; ++key) {
+        auto expected = ref.find(key);
+        CHECK(m.contains(key) == (expected != ref.end()));
+        auto value = m.find(key);
+        CHECK(value.has_value() == (expected != ref.end()));
+        if (value) {
+            CHECK(*value == expected->second);
+        }
+    }
+    std::puts("ok");
+}
@@ -0,0 +1,98 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "map.cpp"
+#include "frozen_map.cpp"
+#include "tests/check.h"
+
+static std::string tempPath(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Пишет заголовок и extra нулевых байт данных; true, если FrozenMap отказался открыть файл.
+static bool rejects(const FrozenMapHeader& header, size_t extra) {
+    std::string path = tempPath("frozen_map_test_bad.frz");
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (size_t i = 0; i < extra; ++i) {
+            out.put(0);
+        }
+    }
+    bool rejected = false;
+    try {
+        FrozenMap<int64_t, int64_t> map(path);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    std::filesystem::remove(path);
+    return rejected;
+}
+
+int main() {
+    std::string path = tempPath("frozen_map_test.frz");
+    Map<int64_t, int64_t> m;
+    std::map<int64_t, int64_t> ref;
+    for (int64_t i = 0; i < 100000; ++i) {
+        int64_t key = (i * 7919) % 200003;
+        m.insert(key, i);
+        ref[key] = i;
+    }
+    freeze(m, path);
+    {
+        FrozenMap<int64_t, int64_t> frozen(path);
+        CHECK(frozen.size() == ref.size());
+        auto it = ref.begin();
+        for (const auto& [key, value] : frozen) {
+            CHECK(key == it->first && value == it->second);
+            ++it;
+        }
+        for (int64_t key = -5; key < 200010; key += 3) {
+            CHECK((frozen.find(key) == frozen.end()) == (ref.find(key) == ref.end()));
+            auto lower = frozen.lowerBound(key);
+            auto ref_lower = ref.lower_bound(key);
+            CHECK(ref_lower == ref.end() ? lower == frozen.end() : lower->first == ref_lower->first);
+        }
+    }
+    try {
+        FrozenMap<int32_t, int64_t> wrong_key(path);
+        CHECK(false);
+    } catch (const std::runtime_error&) {
+    }
+    std::filesystem::remove(path);
+
+    Map<int64_t, int64_t> empty;
+    freeze(empty, path);
+    {
+        FrozenMap<int64_t, int64_t> frozen(path);
+        CHECK(frozen.empty() && frozen.begin() == frozen.end());
+    }
+    std::filesystem::remove(path);
+
+    // 10 ключей с 64-го байта и 10 значений со 192-го: файл ровно 272 байта.
+    FrozenMapHeader header{FrozenMapHeader::kMagic, 10, 8, 8, 64, 192};
+    const size_t data = 272 - sizeof(header);
+    CHECK(!rejects(header, data));
+    CHECK(rejects(header, data - 1));
+    FrozenMapHeader bad = header;
+    bad.values_offset = 64 + 40;
+    CHECK(rejects(bad, data));
+    bad = header;
+    bad.keys_offset = 65;
+    CHECK(rejects(bad, data));
+    bad = header;
+    bad.keys_offset = 8;
+    CHECK(rejects(bad, data));
+    bad = header;
+    bad.count = (uint64_t(1) << 61) + 1;
+    CHECK(rejects(bad, data));
+    bad = header;
+    bad.values_offset = uint64_t(1) << 62;
+    CHECK(rejects(bad, data));
+    std::puts("ok");
+}
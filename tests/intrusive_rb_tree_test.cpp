@@ -0,0 +1,126 @@
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "intrusive_rb_tree.h"
+#include "tests/check.h"
+
+// Каждая заявка одновременно лежит в двух деревьях: по номеру и по цене.
+struct Order {
+    long id;
+    long price;
+    RBHook<Order> by_id;
+    RBHook<Order> by_price;
+};
+
+struct ById {
+    bool operator()(const Order& first, const Order& second) const {
+        return first.id < second.id;
+    }
+    bool operator()(const Order& order, long id) const {
+        return order.id < id;
+    }
+    bool operator()(long id, const Order& order) const {
+        return id < order.id;
+    }
+};
+
+struct ByPrice {
+    bool operator()(const Order& first, const Order& second) const {
+        return std::pair(first.price, first.id) < std::pair(second.price, second.id);
+    }
+};
+
+// Проверяет ссылки на родителей, цвета и чёрные высоты; возвращает чёрную высоту.
+template <RBHook<Order> Order::*Hook>
+static int checkNode(const Order* node, const Order* parent) {
+    if (!node) {
+        return 1;
+    }
+    const RBHook<Order>& hook = node->*Hook;
+    CHECK(hook.parent == parent);
+    if (hook.red) {
+        CHECK(!hook.left || !(hook.left->*Hook).red);
+        CHECK(!hook.right || !(hook.right->*Hook).red);
+    }
+    int left = checkNode<Hook>(hook.left, node);
+    CHECK(left == checkNode<Hook>(hook.right, node));
+    return left + (hook.red ? 0 : 1);
+}
+
+// Находит корень, поднимаясь от any, и проверяет всё дерево.
+template <RBHook<Order> Order::*Hook>
+static void checkShape(const Order* any) {
+    if (!any) {
+        return;
+    }
+    while ((any->*Hook).parent) {
+        any = (any->*Hook).parent;
+    }
+    CHECK(!(any->*Hook).red);
+    checkNode<Hook>(any, nullptr);
+}
+
+int main() {
+    std::mt19937 rng(12);
+    std::vector<Order> pool(5000);
+    for (size_t i = 0; i < pool.size(); ++i) {
+        pool[i].id = static_cast<long>(i);
+        pool[i].price = static_cast<long>(rng() % 100);
+    }
+    IntrusiveRBTree<Order, &Order::by_id, ById> ids;
+    IntrusiveRBTree<Order, &Order::by_price, ByPrice> prices;
+    std::set<long> ref;
+    std::set<std::pair<long, long>> ref_prices;
+    for (int step = 0; step < 200000; ++step) {
+        Order& order = pool[rng() % pool.size()];
+        if (!ref.count(order.id)) {
+            CHECK(ids.insert(order));
+            CHECK(prices.insert(order));
+            ref.insert(order.id);
+            ref_prices.emplace(order.price, order.id);
+        } else {
+            ids.erase(order);
+            prices.erase(order);
+            ref.erase(order.id);
+            ref_prices.erase({order.price, order.id});
+        }
+        if (step % 1000 != 0) {
+            continue;
+        }
+        CHECK(ids.size() == ref.size() && prices.size() == ref.size());
+        auto id_it = ref.begin();
+        for (const Order& found : ids) {
+            CHECK(found.id == *id_it++);
+        }
+        auto price_it = ref_prices.begin();
+        for (const Order& found : prices) {
+            CHECK(found.price == price_it->first && found.id == price_it->second);
+            ++price_it;
+        }
+        if (!ref.empty()) {
+            checkShape<&Order::by_id>(&pool[*ref.begin()]);
+            checkShape<&Order::by_price>(&pool[*ref.begin()]);
+            auto last = ids.end();
+            --last;
+            CHECK(last->id == *ref.rbegin());
+        }
+        long query = static_cast<long>(rng() % pool.size());
+        CHECK((ids.find(query) != ids.end()) == (ref.count(query) > 0));
+        auto lower = ids.lowerBound(query);
+        auto ref_lower = ref.lower_bound(query);
+        CHECK(ref_lower == ref.end() ? lower == ids.end() : lower->id == *ref_lower);
+    }
+
+    // Объект с тем же ключом не вставляется, и его крючок остаётся нетронутым.
+    if (!ref.empty()) {
+        Order duplicate{*ref.begin(), 0, {}, {}};
+        CHECK(!ids.insert(duplicate));
+        CHECK(!duplicate.by_id.parent && !duplicate.by_id.left && !duplicate.by_id.right);
+    }
+    ids.clear();
+    prices.clear();
+    CHECK(ids.empty() && ids.begin() == ids.end());
+    std::puts("ok");
+}
@@ -0,0 +1,49 @@
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "map.cpp"
+#include "tests/check.h"
+
+template <typename K, typename V>
+void checkSame(const Map<K, V>& m, const std::map<K, V>& ref) {
+    m.audit();
+    CHECK(m.size() == ref.size());
+    auto it = ref.begin();
+    for (const auto& [key, value] : m) {
+        CHECK(it != ref.end() && key == it->first && value == it->second);
+        ++it;
+    }
+    CHECK(it == ref.end());
+}
+
+// Дерево после assignSorted должно быть корректным красно-чёрным деревом и
+// выдерживать дальнейшие вставки и удаления.
+int main() {
+    std::mt19937 rng(3);
+    for (int n = 0; n < 600; ++n) {
+        std::vector<std::pair<int, int>> input;
+        std::map<int, int> ref;
+        for (int i = 0; i < n; ++i) {
+            input.emplace_back(i * 2, i);
+            ref.emplace(i * 2, i);
+        }
+        Map<int, int> m;
+        m.insert(-1, -1);
+        m.assignSorted(input.begin(), input.end());
+        checkSame(m, ref);
+        for (int i = 0; i < n; ++i) {
+            int key = static_cast<int>(rng() % (2 * n + 2));
+            if (rng() % 2) {
+                m.insert(key, i);
+                ref[key] = i;
+            } else {
+                m.erase(key);
+                ref.erase(key);
+            }
+        }
+        checkSame(m, ref);
+    }
+    std::puts("ok");
+}
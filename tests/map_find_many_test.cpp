@@ -0,0 +1,62 @@
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "map.cpp"
+#include "tests/check.h"
+
+using TestMap = Map<int, int>;
+
+// Пакетный поиск сверяется с std::map на числе ключей, не кратном ширине пакета,
+// с повторами и ключами за пределами словаря.
+int main() {
+    std::mt19937 rng(7);
+    for (int round = 0; round < 30; ++round) {
+        TestMap m;
+        std::map<int, int> ref;
+        int n = static_cast<int>(rng() % 2000);
+        for (int i = 0; i < n; ++i) {
+            int key = static_cast<int>(rng() % 4000);
+            m.insert(key, i);
+            ref[key] = i;
+        }
+        std::vector<int> keys(rng() % 300);
+        for (int& key : keys) {
+            key = static_cast<int>(rng() % 4200) - 100;
+        }
+        std::vector<TestMap::Iterator> found(keys.size());
+        std::vector<TestMap::Iterator> bounds(keys.size() + 3);
+        m.findMany(keys, found);
+        m.lowerBoundMany(keys, bounds);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            auto expected = ref.find(keys[i]);
+            if (expected == ref.end()) {
+                CHECK(found[i] == m.end());
+            } else {
+                CHECK(found[i] != m.end() && found[i]->second == expected->second);
+            }
+            auto bound = ref.lower_bound(keys[i]);
+            if (bound == ref.end()) {
+                CHECK(bounds[i] == m.end());
+            } else {
+                CHECK(bounds[i] != m.end() && bounds[i]->first == bound->first);
+            }
+        }
+
+        if (!keys.empty()) {
+            std::vector<TestMap::Iterator> short_out(keys.size() - 1);
+            try {
+                m.findMany(keys, short_out);
+                CHECK(false);
+            } catch (const std::invalid_argument&) {
+            }
+            try {
+                m.lowerBoundMany(keys, short_out);
+                CHECK(false);
+            } catch (const std::invalid_argument&) {
+            }
+        }
+    }
+    std::puts("ok");
+}
@@ -0,0 +1,83 @@
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "map.cpp"
+#include "tests/check.h"
+
+template <typename K, typename V>
+void checkSame(const Map<K, V>& m, const std::map<K, V>& ref) {
+    m.audit();
+    CHECK(m.size() == ref.size());
+    auto it = ref.begin();
+    for (const auto& [key, value] : m) {
+        CHECK(it != ref.end() && key == it->first && value == it->second);
+        ++it;
+    }
+    CHECK(it == ref.end());
+}
+
+// Подсказки бывают верными (end() при вставке в конец, lowerBound) и произвольными;
+// результат в любом случае должен совпадать с std::map.
+int main() {
+    std::mt19937 rng(5);
+    Map<int, int> m;
+    std::map<int, int> ref;
+    for (int i = 0; i < 10000; ++i) {
+        m.insert(m.end(), i, i);
+        ref[i] = i;
+    }
+    checkSame(m, ref);
+    for (int step = 0; step < 100000; ++step) {
+        int key = static_cast<int>(rng() % 20000);
+        switch (rng() % 5) {
+            case 0:
+                CHECK(m.insert(m.lowerBound(key), key, step)->first == key);
+                ref[key] = step;
+                break;
+            case 1:
+                m.insert(m.end(), key, step);
+                ref[key] = step;
+                break;
+            case 2:
+                m.insert(m.lowerBound(static_cast<int>(rng() % 20000)), key, step);
+                ref[key] = step;
+                break;
+            case 3: {
+                auto [it, inserted] = m.tryEmplace(key, step);
+                auto [ref_it, ref_inserted] = ref.try_emplace(key, step);
+                CHECK(inserted == ref_inserted && it->second == ref_it->second);
+                break;
+            }
+            default:
+                m.erase(key);
+                ref.erase(key);
+        }
+        if (step % 5000 == 0) {
+            checkSame(m, ref);
+        }
+    }
+    checkSame(m, ref);
+
+    // Значения только с перемещением: tryEmplace не трогает аргументы при существующем ключе.
+    Map<int, std::unique_ptr<int>> owners;
+    owners.tryEmplace(3, std::make_unique<int>(3));
+    auto spare = std::make_unique<int>(4);
+    auto [it, inserted] = owners.tryEmplace(3, std::move(spare));
+    CHECK(!inserted && *it->second == 3 && spare);
+    owners.insertOrAssign(3, std::make_unique<int>(5));
+    CHECK(*owners.find(3)->second == 5);
+    owners.emplace(1, std::make_unique<int>(1));
+    owners.insert(owners.end(), 10, std::make_unique<int>(10));
+    CHECK(owners.size() == 3);
+
+    Map<std::string, std::string> strings;
+    strings.tryEmplace("key", 5, 'x');
+    strings.emplace(std::piecewise_construct, std::forward_as_tuple("a"),
+                    std::forward_as_tuple(3, 'b'));
+    CHECK(strings.find("key")->second == "xxxxx" && strings.find("a")->second == "bbb");
+    std::puts("ok");
+}
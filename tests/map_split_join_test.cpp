@@ -0,0 +1,173 @@
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#include "map.cpp"
+#include "tests/check.h"
+
+// Блоки вершин выделяются выровненным operator new; счётчик живых блоков показывает,
+// что память отдаётся, как только её перестали держать все части.
+static long live_blocks = 0;
+
+void* operator new(size_t size, std::align_val_t align) {
+    ++live_blocks;
+    size_t alignment = static_cast<size_t>(align);
+    void* res = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (!res) {
+        throw std::bad_alloc();
+    }
+    return res;
+}
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    --live_blocks;
+    std::free(ptr);
+}
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    --live_blocks;
+    std::free(ptr);
+}
+
+template <typename K, typename V>
+void checkSame(const Map<K, V>& m, const std::map<K, V>& ref) {
+    m.audit();
+    CHECK(m.size() == ref.size());
+    auto it = ref.begin();
+    for (const auto& [key, value] : m) {
+        CHECK(it != ref.end() && key == it->first && value == it->second);
+        ++it;
+    }
+    CHECK(it == ref.end());
+}
+
+int main() {
+    for (unsigned seed = 0; seed < 60; ++seed) {
+        std::mt19937 rng(seed);
+        Map<int, int> m;
+        std::map<int, int> ref;
+        int n = static_cast<int>(rng() % 3000);
+        for (int i = 0; i < n; ++i) {
+            int key = static_cast<int>(rng() % 10000);
+            m.insert(key, i);
+            ref[key] = i;
+        }
+        int pivot = static_cast<int>(rng() % 10400) - 200;
+        Map<int, int> right = m.split(pivot);
+        std::map<int, int> ref_right(ref.lower_bound(pivot), ref.end());
+        ref.erase(ref.lower_bound(pivot), ref.end());
+        checkSame(m, ref);
+        checkSame(right, ref_right);
+        // Размер части без пересчёта считается обходом, после countSize() — хранится
+        // и дальше поддерживается вставками и удалениями (это проверяет audit()).
+        if (seed % 2) {
+            CHECK(m.countSize() == ref.size());
+            CHECK(right.countSize() == ref_right.size());
+        }
+
+        // Части живут независимо: изменения одной не видны в другой.
+        for (int i = 0; i < 200; ++i) {
+            int key = static_cast<int>(rng() % 10000);
+            if (key < pivot) {
+                m.erase(key);
+                ref.erase(key);
+            } else {
+                right.insert(key, -i);
+                ref_right[key] = -i;
+            }
+        }
+        checkSame(m, ref);
+        checkSame(right, ref_right);
+
+        if (!ref.empty() && !ref_right.empty()) {
+            Map<int, int> overlap;
+            overlap.insert(ref.begin()->first, 0);
+            overlap.insert(ref_right.begin()->first, 0);
+            try {
+                m.join(std::move(overlap));
+                CHECK(false);
+            } catch (const std::runtime_error&) {
+            }
+        }
+
+        ref.insert(ref_right.begin(), ref_right.end());
+        if (rng() % 2) {
+            m.join(std::move(right));
+        } else {
+            right.join(std::move(m));
+            m = std::move(right);
+        }
+        checkSame(m, ref);
+        for (int i = 0; i < 500; ++i) {
+            int key = static_cast<int>(rng() % 10000);
+            m.insert(key, i);
+            ref[key] = i;
+        }
+        checkSame(m, ref);
+    }
+
+    // Вершины после split принадлежат разным деревьям, но общим блокам памяти:
+    // уничтожение одной части не должно задевать другую.
+    {
+        Map<int, int> left;
+        std::map<int, int> ref;
+        for (int i = 0; i < 5000; ++i) {
+            left.insert(i, i);
+            ref[i] = i;
+        }
+        {
+            Map<int, int> right = left.split(2500);
+            right.insert(100000, 0);
+        }
+        ref.erase(ref.lower_bound(2500), ref.end());
+        checkSame(left, ref);
+    }
+
+    // Уничтоженная или очищенная часть отдаёт блоки, которые держала только она.
+    {
+        Map<int, int> left;
+        for (int i = 0; i < 100000; ++i) {
+            left.insert(i, i);
+        }
+        long whole = live_blocks;
+        Map<int, int> right = left.split(50000);
+        right.clear();
+        CHECK(live_blocks <= whole / 2 + 2);
+        left.clear();
+        CHECK(live_blocks == 0);
+
+        for (int i = 0; i < 100000; ++i) {
+            left.insert(i, i);
+        }
+        {
+            Map<int, int> middle = left.split(25000);
+            Map<int, int> tail = middle.split(75000);
+            left.join(std::move(tail));
+        }
+        CHECK(live_blocks <= whole / 2 + 3);
+        left.clear();
+        CHECK(live_blocks == 0);
+    }
+
+    // Длинная цепочка split и join не накапливает память.
+    Map<int, int> m;
+    for (int i = 0; i < 1000; ++i) {
+        m.insert(i, i);
+    }
+    long before = live_blocks;
+    for (int i = 0; i < 100000; ++i) {
+        Map<int, int> right = m.split(500);
+        m.join(std::move(right));
+        if (i % 1000 == 0) {
+            m.erase(i % 1000);
+            m.insert(i % 1000, i);
+        }
+    }
+    m.audit();
+    CHECK(m.size() == 1000);
+    CHECK(live_blocks <= before + 1);
+    m.clear();
+    CHECK(live_blocks == 0);
+    std::puts("ok");
+}
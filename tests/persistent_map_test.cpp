@@ -0,0 +1,132 @@
+#include <atomic>
+#include <deque>
+#include <map>
+#include <random>
+#include <thread>
+#include <utility>
+
+#include "persistent_map.cpp"
+#include "tests/check.h"
+
+// Значение, которое считает свои живые копии: каждая вершина хранит ровно одну,
+// поэтому счётчик показывает, сколько вершин ещё не освобождено.
+struct Tracked {
+    static std::atomic<long> live;
+
+    int value;
+
+    Tracked(int value) : value(value) {
+        ++live;
+    }
+    Tracked(const Tracked& other) : value(other.value) {
+        ++live;
+    }
+    Tracked& operator=(const Tracked& other) {
+        value = other.value;
+        return *this;
+    }
+    ~Tracked() {
+        --live;
+    }
+};
+std::atomic<long> Tracked::live = 0;
+
+using Persistent = PersistentMap<int, Tracked>;
+
+void checkSame(const Persistent::Snapshot& snapshot, const std::map<int, int>& ref) {
+    CHECK(snapshot.size() == ref.size());
+    auto it = ref.begin();
+    for (auto pit = snapshot.begin(); pit != snapshot.end(); ++pit) {
+        CHECK(it != ref.end() && pit->first == it->first && pit->second.value == it->second);
+        ++it;
+    }
+    CHECK(it == ref.end());
+    for (int key = -1; key <= 2001; key += 97) {
+        auto found = snapshot.find(key);
+        auto expected = ref.find(key);
+        CHECK((found == snapshot.end()) == (expected == ref.end()));
+        if (expected != ref.end()) {
+            CHECK(found->second.value == expected->second);
+        }
+    }
+}
+
+int main() {
+    for (unsigned seed = 0; seed < 20; ++seed) {
+        std::mt19937 rng(seed);
+        {
+            Persistent m;
+            std::map<int, int> ref;
+            // Сохранённые срезы вместе с тем, что они должны показывать.
+            std::deque<std::pair<Persistent::Snapshot, std::map<int, int>>> versions;
+            for (int i = 0; i < 4000; ++i) {
+                int key = static_cast<int>(rng() % 2000);
+                if (rng() % 3) {
+                    m.insert(key, i);
+                    ref[key] = i;
+                } else {
+                    m.erase(key);
+                    ref.erase(key);
+                }
+                CHECK(m.size() == ref.size());
+                if (i % 50 == 0) {
+                    versions.emplace_back(m.snapshot(), ref);
+                }
+                // Старые срезы исчезают в случайном порядке, а не только с начала.
+                if (versions.size() > 8) {
+                    size_t victim = rng() % versions.size();
+                    checkSame(versions[victim].first, versions[victim].second);
+                    versions.erase(versions.begin() + victim);
+                }
+            }
+            for (const auto& [snapshot, expected] : versions) {
+                checkSame(snapshot, expected);
+            }
+            checkSame(m.snapshot(), ref);
+
+            // Без срезов живы только вершины текущей версии.
+            versions.clear();
+            CHECK(Tracked::live == static_cast<long>(ref.size()));
+
+            // Копия словаря — ещё одна версия: расходится с оригиналом после записи.
+            Persistent copy = m;
+            std::map<int, int> copy_ref = ref;
+            for (int i = 0; i < 200; ++i) {
+                int key = static_cast<int>(rng() % 2000);
+                copy.erase(key);
+                copy_ref.erase(key);
+            }
+            checkSame(m.snapshot(), ref);
+            checkSame(copy.snapshot(), copy_ref);
+        }
+        CHECK(Tracked::live == 0);
+    }
+
+    // Срез читается в другом потоке, пока писатель меняет словарь и отпускает версии.
+    {
+        Persistent m;
+        std::map<int, int> ref;
+        for (int i = 0; i < 3000; ++i) {
+            m.insert(i, i);
+            ref[i] = i;
+        }
+        Persistent::Snapshot snapshot = m.snapshot();
+        std::thread reader([&snapshot, &ref] {
+            for (int round = 0; round < 20; ++round) {
+                checkSame(snapshot, ref);
+            }
+        });
+        std::mt19937 rng(7);
+        for (int i = 0; i < 20000; ++i) {
+            int key = static_cast<int>(rng() % 3000);
+            if (rng() % 2) {
+                m.insert(key, -i);
+            } else {
+                m.erase(key);
+            }
+        }
+        reader.join();
+    }
+    CHECK(Tracked::live == 0);
+    std::puts("ok");
+}
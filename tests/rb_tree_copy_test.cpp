@@ -0,0 +1,177 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rb_tree.h"
+#include "tests/check.h"
+
+// Выделения памяти считаются, чтобы проверить, что копия до первого изменения
+// ничего не выделяет. Блоки вершин выделяются выровненным operator new.
+static std::atomic<long long> allocations{0};
+
+static void* allocate(size_t size, size_t alignment) {
+    ++allocations;
+    size = (size + alignment - 1) / alignment * alignment;
+    if (void* res = std::aligned_alloc(alignment, size ? size : alignment)) {
+        return res;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) {
+    return allocate(size, alignof(std::max_align_t));
+}
+void* operator new(size_t size, std::align_val_t align) {
+    return allocate(size, static_cast<size_t>(align));
+}
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+static void checkSame(const RBTree<int>& tree, const std::set<int>& ref) {
+    tree.audit();
+    CHECK(tree.size() == ref.size());
+    auto it = ref.begin();
+    for (int value : tree) {
+        CHECK(it != ref.end() && value == *it);
+        ++it;
+    }
+    CHECK(it == ref.end());
+}
+
+int main() {
+    // Копия ничего не выделяет, пока одно из деревьев не изменится; вставка уже
+    // имеющегося значения изменением не считается.
+    {
+        RBTree<int> source;
+        for (int i = 0; i < 100; ++i) {
+            source.insert(i);
+        }
+        long long before = allocations;
+        RBTree<int> copy = source;
+        RBTree<int> assigned;
+        assigned = source;
+        copy.insert(10);
+        assigned.erase(1000);
+        long long sum = 0;
+        for (int value : copy) {
+            sum += value;
+        }
+        CHECK(sum == 4950 && copy.find(50) != copy.end());
+        CHECK(allocations == before);
+        copy.insert(1000);
+        CHECK(allocations > before);
+        CHECK(copy.size() == 101 && source.size() == 100 && assigned.size() == 100);
+    }
+
+    // Итераторы дерева, которое не менялось, переживают изменения и уничтожение копий.
+    // Изменившееся разделённое дерево копирует вершины себе, и устаревают только его
+    // итераторы.
+    {
+        RBTree<int> source;
+        for (int i = 0; i < 100; ++i) {
+            source.insert(i);
+        }
+        auto it = source.find(50);
+        {
+            RBTree<int> copy = source;
+            copy.erase(50);
+            copy.insert(500);
+            CHECK(copy.find(50) == copy.end() && copy.size() == 100);
+        }
+        CHECK(*it == 50);
+        source.insert(200);
+        CHECK(*it == 50);
+        ++it;
+        CHECK(*it == 51);
+
+        RBTree<int> copy = source;
+        auto copy_it = copy.find(60);
+        source.erase(60);
+        CHECK(*copy_it == 60 && copy.find(60) != copy.end());
+        CHECK(source.find(60) == source.end() && source.size() == 100 && copy.size() == 101);
+    }
+
+    // Копии, clone() и перемещения независимы от исходного дерева.
+    std::mt19937 rng(7);
+    RBTree<int> tree;
+    std::set<int> ref;
+    for (int round = 0; round < 200; ++round) {
+        for (int i = 0; i < 200; ++i) {
+            int value = static_cast<int>(rng() % 2000);
+            if (rng() % 3) {
+                tree.insert(value);
+                ref.insert(value);
+            } else {
+                tree.erase(value);
+                ref.erase(value);
+            }
+        }
+        RBTree<int> copy = tree;
+        RBTree<int> cloned = tree.clone();
+        RBTree<int> assigned;
+        assigned.insert(-1);
+        assigned = tree;
+        const std::set<int> snapshot = ref;
+        std::set<int> ref_copy = ref;
+        for (int i = 0; i < 50; ++i) {
+            int value = static_cast<int>(rng() % 2000);
+            tree.insert(value);
+            ref.insert(value);
+            copy.erase(value);
+            ref_copy.erase(value);
+        }
+        checkSame(tree, ref);
+        checkSame(copy, ref_copy);
+        checkSame(cloned, snapshot);
+        checkSame(assigned, snapshot);
+        RBTree<int> moved = std::move(copy);
+        checkSame(moved, ref_copy);
+        CHECK(copy.size() == 0 && copy.begin() == copy.end());
+        copy = std::move(moved);
+        checkSame(copy, ref_copy);
+        tree = tree;
+        checkSame(tree, ref);
+    }
+
+    // Копирование только читает исходное дерево, поэтому копии можно снимать
+    // из нескольких потоков одновременно.
+    RBTree<int> shared;
+    std::set<int> ref_shared;
+    for (int i = 0; i < 20000; ++i) {
+        int value = static_cast<int>(rng() % 100000);
+        shared.insert(value);
+        ref_shared.insert(value);
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&shared, &ref_shared, t] {
+            for (int i = 0; i < 5; ++i) {
+                RBTree<int> copy = shared;
+                copy.insert(-1 - t);
+                CHECK(copy.size() == ref_shared.size() + 1);
+                CHECK(*copy.begin() == -1 - t);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    checkSame(shared, ref_shared);
+    std::puts("ok");
+}
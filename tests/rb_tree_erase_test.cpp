@@ -0,0 +1,97 @@
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "rb_tree.h"
+#include "tests/check.h"
+
+// Блоки вершин выделяются выровненным operator new; счётчик показывает, что
+// вставки после удалений берут вершины из списка свободных.
+static long aligned_allocations = 0;
+
+void* operator new(size_t size, std::align_val_t align) {
+    ++aligned_allocations;
+    size_t alignment = static_cast<size_t>(align);
+    void* res = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (!res) {
+        throw std::bad_alloc();
+    }
+    return res;
+}
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+static void checkSame(const RBTree<int>& tree, const std::set<int>& ref) {
+    tree.audit();
+    CHECK(tree.size() == ref.size());
+    auto it = ref.begin();
+    for (int value : tree) {
+        CHECK(it != ref.end() && value == *it);
+        ++it;
+    }
+    CHECK(it == ref.end());
+}
+
+int main() {
+    std::mt19937 rng(3);
+    RBTree<int> tree;
+    std::set<int> ref;
+    for (int step = 0; step < 300000; ++step) {
+        int value = static_cast<int>(rng() % 4000);
+        if (rng() % 2) {
+            tree.insert(value);
+            ref.insert(value);
+        } else {
+            tree.erase(value);
+            ref.erase(value);
+        }
+        if (step % 1000 == 0) {
+            checkSame(tree, ref);
+        }
+    }
+    checkSame(tree, ref);
+
+    // Удаление других элементов не трогает вершину, на которую указывает итератор.
+    int kept = *ref.begin();
+    auto kept_it = tree.find(kept);
+    for (int value : std::vector<int>(ref.begin(), ref.end())) {
+        if (value != kept && rng() % 2) {
+            tree.erase(value);
+            ref.erase(value);
+        }
+    }
+    CHECK(*kept_it == kept);
+    checkSame(tree, ref);
+
+    long before = aligned_allocations;
+    for (int i = 0; i < 100000; ++i) {
+        tree.insert(10000 + i);
+        tree.erase(10000 + i);
+    }
+    CHECK(before > 0 && aligned_allocations == before);
+
+    while (!ref.empty()) {
+        tree.erase(*ref.begin());
+        ref.erase(ref.begin());
+    }
+    checkSame(tree, ref);
+    CHECK(!tree.root);
+
+    RBTree<std::string> strings;
+    for (int i = 0; i < 1000; ++i) {
+        strings.insert(std::to_string(i));
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        strings.erase(std::to_string(i));
+    }
+    strings.audit();
+    CHECK(strings.size() == 500 && strings.find("10") == strings.end() && *strings.find("11") == "11");
+    std::puts("ok");
+}
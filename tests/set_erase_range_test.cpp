@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <climits>
+#include <iterator>
+#include <random>
+#include <set>
+
+#include "set.cpp"
+#include "tests/check.h"
+
+using Tree = RBTree<int, SumMonoid<int>>;
+using TreeNode = Node<int, SumMonoid<int>>;
+
+// Проверяет связи, порядок, цвета, размеры и суммы поддеревьев; возвращает чёрную высоту.
+static int checkNode(const TreeNode* node, const TreeNode* parent) {
+    if (!node) {
+        return 1;
+    }
+    CHECK(node->parent == parent);
+    CHECK(!node->left || node->left->value < node->value);
+    CHECK(!node->right || node->value < node->right->value);
+    if (node->color == Color::RED) {
+        CHECK(!node->left || node->left->color == Color::BLACK);
+        CHECK(!node->right || node->right->color == Color::BLACK);
+    }
+    size_t size = 1;
+    long sum = node->value;
+    for (const TreeNode* child : {node->left, node->right}) {
+        if (child) {
+            size += child->sub_size;
+            sum += child->summary;
+        }
+    }
+    CHECK(node->sub_size == size && node->summary == sum);
+    int left = checkNode(node->left, node);
+    CHECK(left == checkNode(node->right, node));
+    return left + (node->color == Color::BLACK ? 1 : 0);
+}
+
+// После каждого удаления сверяются структура, size(), select и aggregate на случайных
+// диапазонах.
+static void checkSame(const Tree& tree, const std::set<int>& ref, std::mt19937& rng) {
+    CHECK(!tree.root || tree.root->color == Color::BLACK);
+    checkNode(tree.root, nullptr);
+    CHECK(tree.size() == ref.size());
+    size_t rank = 0;
+    long sum = 0;
+    for (int value : ref) {
+        CHECK(tree.select(rank++) == value);
+        sum += value;
+    }
+    CHECK(tree.aggregate(INT_MIN, INT_MAX) == sum);
+    for (int probe = 0; probe < 20; ++probe) {
+        int lo = static_cast<int>(rng() % 2200) - 100;
+        int hi = static_cast<int>(rng() % 2200) - 100;
+        long expected = 0;
+        for (auto it = ref.lower_bound(lo); it != ref.end() && *it < hi; ++it) {
+            expected += *it;
+        }
+        CHECK(tree.aggregate(lo, hi) == expected);
+    }
+}
+
+static void fill(Tree& tree, std::set<int>& ref, std::mt19937& rng, int count) {
+    for (int i = 0; i < count; ++i) {
+        int value = static_cast<int>(rng() % 2000);
+        tree.insert(value);
+        ref.insert(value);
+    }
+}
+
+static size_t eraseReference(std::set<int>& ref, size_t first, size_t last) {
+    last = std::min(last, ref.size());
+    if (first >= last) {
+        return 0;
+    }
+    ref.erase(std::next(ref.begin(), first), std::next(ref.begin(), last));
+    return last - first;
+}
+
+int main() {
+    std::mt19937 rng(16);
+
+    // Пустое дерево: удалять нечего ни по значениям, ни по номерам.
+    {
+        Tree tree;
+        std::set<int> ref;
+        CHECK(tree.eraseRange(0, 100) == 0);
+        CHECK(tree.eraseRanks(0, 10) == 0);
+        checkSame(tree, ref, rng);
+    }
+
+    for (int round = 0; round < 40; ++round) {
+        Tree tree;
+        std::set<int> ref;
+        fill(tree, ref, rng, 1 + static_cast<int>(rng() % 1500));
+        checkSame(tree, ref, rng);
+
+        // Пустые диапазоны: lo >= hi и first >= last ничего не меняют.
+        int pivot = static_cast<int>(rng() % 2000);
+        CHECK(tree.eraseRange(pivot, pivot) == 0);
+        CHECK(tree.eraseRange(pivot + 10, pivot) == 0);
+        CHECK(tree.eraseRanks(3, 3) == 0);
+        CHECK(tree.eraseRanks(5, 2) == 0);
+        CHECK(tree.eraseRanks(ref.size(), ref.size() + 10) == 0);
+        checkSame(tree, ref, rng);
+
+        // Префикс, суффикс и середина по значениям.
+        int cut = static_cast<int>(rng() % 2000);
+        size_t expected = std::distance(ref.begin(), ref.lower_bound(cut));
+        CHECK(tree.eraseRange(INT_MIN, cut) == expected);
+        ref.erase(ref.begin(), ref.lower_bound(cut));
+        checkSame(tree, ref, rng);
+
+        cut = static_cast<int>(rng() % 2000);
+        expected = std::distance(ref.lower_bound(cut), ref.end());
+        CHECK(tree.eraseRange(cut, INT_MAX) == expected);
+        ref.erase(ref.lower_bound(cut), ref.end());
+        checkSame(tree, ref, rng);
+
+        fill(tree, ref, rng, static_cast<int>(rng() % 1500));
+        for (int op = 0; op < 10; ++op) {
+            int lo = static_cast<int>(rng() % 2100) - 50;
+            int hi = lo + static_cast<int>(rng() % 300);
+            expected = std::distance(ref.lower_bound(lo), ref.lower_bound(hi));
+            CHECK(tree.eraseRange(lo, hi) == expected);
+            ref.erase(ref.lower_bound(lo), ref.lower_bound(hi));
+            checkSame(tree, ref, rng);
+
+            // То же по номерам, включая выход last за size().
+            size_t first = rng() % (ref.size() + 2);
+            size_t last = first + rng() % 100;
+            CHECK(tree.eraseRanks(first, last) == eraseReference(ref, first, last));
+            checkSame(tree, ref, rng);
+        }
+
+        // Префикс и суффикс по номерам.
+        fill(tree, ref, rng, static_cast<int>(rng() % 1500));
+        size_t k = rng() % (ref.size() + 1);
+        CHECK(tree.eraseRanks(0, k) == eraseReference(ref, 0, k));
+        checkSame(tree, ref, rng);
+        k = rng() % (ref.size() + 1);
+        size_t end = ref.size();
+        CHECK(tree.eraseRanks(k, end) == eraseReference(ref, k, end));
+        checkSame(tree, ref, rng);
+
+        // Всё дерево: по значениям или по номерам, после чего дерево снова пригодно.
+        fill(tree, ref, rng, static_cast<int>(rng() % 500));
+        size_t total = ref.size();
+        if (round % 2) {
+            CHECK(tree.eraseRange(INT_MIN, INT_MAX) == total);
+        } else {
+            CHECK(tree.eraseRanks(0, total) == total);
+        }
+        ref.clear();
+        checkSame(tree, ref, rng);
+        fill(tree, ref, rng, 100);
+        checkSame(tree, ref, rng);
+    }
+    std::puts("ok");
+}
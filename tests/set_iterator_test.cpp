@@ -0,0 +1,99 @@
+#include <random>
+#include <set>
+#include <vector>
+
+#include "set.cpp"
+#include "tests/check.h"
+
+using Tree = RBTree<int>;
+using Diff = Tree::Iterator::difference_type;
+
+// Сверяет арифметику итераторов с номерами элементов в отсортированном эталоне:
+// итератор с номером i — это begin() + i, для i == size() это end().
+static void checkRanks(const Tree& tree, const std::vector<int>& sorted, std::mt19937& rng) {
+    Diff n = static_cast<Diff>(sorted.size());
+    CHECK(tree.size() == sorted.size());
+    CHECK(tree.end() - tree.begin() == n);
+    CHECK(tree.begin() - tree.end() == -n);
+    CHECK(tree.begin() + n == tree.end());
+    CHECK(tree.end() - n == tree.begin());
+    CHECK(tree.begin() + 0 == tree.begin() && tree.end() - 0 == tree.end());
+
+    auto at = [&](Diff i) {
+        return i == n ? tree.end() : tree.begin() + i;
+    };
+    for (int probe = 0; probe < 200; ++probe) {
+        Diff i = static_cast<Diff>(rng() % (sorted.size() + 1));
+        Diff j = static_cast<Diff>(rng() % (sorted.size() + 1));
+        Tree::Iterator it = tree.begin() + i;
+        CHECK(static_cast<Diff>(it.index()) == i);
+        CHECK(it - tree.begin() == i && tree.end() - it == n - i);
+        CHECK(it == at(i) && tree.end() - (n - i) == it && i + tree.begin() == it);
+        if (i < n) {
+            CHECK(*it == sorted[i] && tree.begin()[i] == sorted[i]);
+        }
+
+        Tree::Iterator other = tree.begin() + j;
+        CHECK(other - it == j - i);
+        CHECK(it + (j - i) == other && other - (j - i) == it);
+        CHECK((it < other) == (i < j) && (it <= other) == (i <= j));
+        CHECK((it > other) == (i > j) && (it >= other) == (i >= j));
+
+        Tree::Iterator moved = it;
+        moved += j - i;
+        CHECK(moved == other);
+        moved -= j - i;
+        CHECK(moved == it);
+    }
+
+    // Пошаговый обход даёт те же итераторы, что и сдвиг.
+    Tree::Iterator step = tree.begin();
+    for (Diff i = 0; i < n; ++i, ++step) {
+        CHECK(step == tree.begin() + i && step - tree.begin() == i);
+    }
+    CHECK(step == tree.end());
+    for (Diff i = n; i > 0; --i) {
+        --step;
+        CHECK(step == tree.end() - (n - i + 1));
+    }
+}
+
+int main() {
+    std::mt19937 rng(15);
+
+    // Пустое дерево: begin() совпадает с end(), все расстояния нулевые.
+    {
+        Tree empty;
+        CHECK(empty.begin() == empty.end());
+        CHECK(empty.end() - empty.begin() == 0);
+        CHECK(empty.begin() + 0 == empty.end() && empty.end() - 0 == empty.begin());
+        checkRanks(empty, {}, rng);
+    }
+
+    for (size_t limit : {1, 2, 3, 10, 100, 5000}) {
+        Tree tree;
+        std::set<int> ref;
+        while (ref.size() < limit) {
+            int value = static_cast<int>(rng() % (limit * 4));
+            tree.insert(value);
+            ref.insert(value);
+        }
+        checkRanks(tree, std::vector<int>(ref.begin(), ref.end()), rng);
+
+        // Номера пересчитываются после удалений и вставок.
+        for (int round = 0; round < 5; ++round) {
+            for (size_t op = 0; op < limit / 2 + 1; ++op) {
+                int value = static_cast<int>(rng() % (limit * 4));
+                if (rng() % 2) {
+                    tree.insert(value);
+                    ref.insert(value);
+                } else {
+                    tree.erase(value);
+                    ref.erase(value);
+                }
+            }
+            checkRanks(tree, std::vector<int>(ref.begin(), ref.end()), rng);
+        }
+    }
+    std::puts("ok");
+}
@@ -0,0 +1,120 @@
+#include <climits>
+#include <random>
+#include <set>
+#include <utility>
+
+#include "set.cpp"
+#include "tests/check.h"
+
+using Tree = RBTree<int, SumMonoid<int>>;
+using TreeNode = Node<int, SumMonoid<int>>;
+
+// Проверяет связи, порядок, цвета, размеры и суммы поддеревьев; возвращает чёрную высоту.
+static int checkNode(const TreeNode* node, const TreeNode* parent) {
+    if (!node) {
+        return 1;
+    }
+    CHECK(node->parent == parent);
+    CHECK(!node->left || node->left->value < node->value);
+    CHECK(!node->right || node->value < node->right->value);
+    if (node->color == Color::RED) {
+        CHECK(!node->left || node->left->color == Color::BLACK);
+        CHECK(!node->right || node->right->color == Color::BLACK);
+    }
+    size_t size = 1;
+    long sum = node->value;
+    for (const TreeNode* child : {node->left, node->right}) {
+        if (child) {
+            size += child->sub_size;
+            sum += child->summary;
+        }
+    }
+    CHECK(node->sub_size == size && node->summary == sum);
+    int left = checkNode(node->left, node);
+    CHECK(left == checkNode(node->right, node));
+    return left + (node->color == Color::BLACK ? 1 : 0);
+}
+
+static void checkSame(const Tree& tree, const std::set<int>& ref) {
+    CHECK(!tree.root || tree.root->color == Color::BLACK);
+    checkNode(tree.root, nullptr);
+    CHECK(tree.size() == ref.size());
+    size_t rank = 0;
+    long sum = 0;
+    for (int value : ref) {
+        CHECK(tree.select(rank++) == value);
+        sum += value;
+    }
+    CHECK(tree.aggregate(INT_MIN, INT_MAX) == sum);
+}
+
+// Размеры доходят до нескольких kParallelGrain, так что верхние уровни рекурсии
+// считаются в отдельных потоках; ThreadSanitizer-сборка этого теста тоже должна проходить.
+int main() {
+    std::mt19937 rng(5);
+    for (int round = 0; round < 20; ++round) {
+        int n1 = static_cast<int>(rng() % 40000);
+        int n2 = static_cast<int>(rng() % 40000);
+        int range = 1 + static_cast<int>(rng() % 80000);
+        for (int op = 0; op < 3; ++op) {
+            Tree a;
+            Tree b;
+            std::set<int> ref_a;
+            std::set<int> ref_b;
+            for (int i = 0; i < n1; ++i) {
+                int value = static_cast<int>(rng() % range);
+                a.insert(value);
+                ref_a.insert(value);
+            }
+            for (int i = 0; i < n2; ++i) {
+                int value = static_cast<int>(rng() % range);
+                b.insert(value);
+                ref_b.insert(value);
+            }
+            std::set<int> expected;
+            if (op == 0) {
+                a.unionWith(std::move(b));
+                expected = ref_a;
+                expected.insert(ref_b.begin(), ref_b.end());
+            } else if (op == 1) {
+                a.intersectWith(std::move(b));
+                for (int value : ref_a) {
+                    if (ref_b.count(value)) {
+                        expected.insert(value);
+                    }
+                }
+            } else {
+                a.differenceWith(std::move(b));
+                for (int value : ref_a) {
+                    if (!ref_b.count(value)) {
+                        expected.insert(value);
+                    }
+                }
+            }
+            checkSame(a, expected);
+            CHECK(b.size() == 0 && !b.root);
+
+            // Результат остаётся обычным деревом: его можно менять и снова объединять.
+            for (int i = 0; i < 100; ++i) {
+                int value = static_cast<int>(rng() % range);
+                if (rng() % 2) {
+                    a.insert(value);
+                    expected.insert(value);
+                } else {
+                    a.erase(value);
+                    expected.erase(value);
+                }
+            }
+            Tree c;
+            c.insert(range + 1);
+            a.unionWith(std::move(c));
+            expected.insert(range + 1);
+            checkSame(a, expected);
+        }
+    }
+    Tree self;
+    self.insert(1);
+    self.unionWith(std::move(self));
+    CHECK(self.size() == 1);
+    std::puts("ok");
+}
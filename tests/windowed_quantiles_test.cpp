@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "windowed_quantiles.cpp"
+#include "tests/check.h"
+
+// Окно сверяется с отсортированной копией последних window отсчётов; значения
+// берутся из малого диапазона, чтобы в окне было много повторов.
+int main() {
+    std::mt19937 rng(11);
+    const std::vector<double> qs = {0.99, 0.0, 0.5, 1.0, 0.25, 0.5, 0.9};
+    for (size_t window : {1, 2, 7, 100, 1000}) {
+        WindowedQuantiles<int> wq(window);
+        std::deque<int> recent;
+        for (int step = 0; step < 20000; ++step) {
+            int sample = static_cast<int>(rng() % 50);
+            wq.add(sample);
+            recent.push_back(sample);
+            if (recent.size() > window) {
+                recent.pop_front();
+            }
+            CHECK(wq.size() == recent.size());
+            if (step % 37 != 0) {
+                continue;
+            }
+            std::vector<int> sorted(recent.begin(), recent.end());
+            std::sort(sorted.begin(), sorted.end());
+            std::vector<int> out(qs.size());
+            wq.quantiles(qs, out);
+            for (size_t i = 0; i < qs.size(); ++i) {
+                size_t rank = static_cast<size_t>(std::floor(qs[i] * (sorted.size() - 1)));
+                CHECK(out[i] == sorted[rank]);
+                CHECK(wq.quantile(qs[i]) == sorted[rank]);
+            }
+        }
+    }
+
+    WindowedQuantiles<int> empty(3);
+    try {
+        empty.quantile(0.5);
+        CHECK(false);
+    } catch (const std::out_of_range&) {
+    }
+    empty.add(1);
+    try {
+        empty.quantile(1.5);
+        CHECK(false);
+    } catch (const std::out_of_range&) {
+    }
+
+    // selectMany принимает только неубывающие номера.
+    RBTree<int> tree;
+    for (int i = 0; i < 100; ++i) {
+        tree.insert(i * 2);
+    }
+    std::vector<size_t> ranks = {0, 5, 5, 99};
+    std::vector<int> found(ranks.size());
+    tree.selectMany(ranks, found);
+    CHECK((found == std::vector<int>{0, 10, 10, 198}));
+    std::vector<size_t> unsorted = {5, 0};
+    try {
+        tree.selectMany(unsorted, found);
+        CHECK(false);
+    } catch (const std::invalid_argument&) {
+    }
+    std::vector<size_t> too_far = {100};
+    try {
+        tree.selectMany(too_far, found);
+        CHECK(false);
+    } catch (const std::out_of_range&) {
+    }
+    std::puts("ok");
+}
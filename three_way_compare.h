@@ -0,0 +1,53 @@
+#pragma once
+
+#include <compare>
+#include <concepts>
+#include <functional>
+#include <type_traits>
+
+// Трёхстороннее сравнение для деревьев: на каждой вершине поиск делает одно
+// сравнение вместо пары вызовов < и проверки на равенство.
+
+template <typename Compare>
+struct IsStdLess : std::false_type {};
+
+template <typename T>
+struct IsStdLess<std::less<T>> : std::true_type {};
+
+// Компаратор сам возвращает упорядочение (например, std::compare_three_way).
+template <typename Compare, typename A, typename B>
+concept ThreeWayComparator = requires(const Compare& comp, const A& first, const B& second) {
+    { comp(first, second) } -> std::convertible_to<std::weak_ordering>;
+};
+
+template <typename Compare, typename A, typename B>
+std::weak_ordering threeWay(const Compare& comp, const A& first, const B& second) {
+    if constexpr (ThreeWayComparator<Compare, A, B>) {
+        return comp(first, second);
+    } else if constexpr (IsStdLess<Compare>::value &&
+                         std::three_way_comparable_with<A, B, std::weak_ordering>) {
+        return first <=> second;
+    } else {
+        if (comp(first, second)) {
+            return std::weak_ordering::less;
+        }
+        if (comp(second, first)) {
+            return std::weak_ordering::greater;
+        }
+        return std::weak_ordering::equivalent;
+    }
+}
+
+template <typename A, typename B>
+std::weak_ordering threeWay(const A& first, const B& second) {
+    return threeWay(std::less<>(), first, second);
+}
+
+template <typename Compare, typename A, typename B>
+bool lessThan(const Compare& comp, const A& first, const B& second) {
+    if constexpr (ThreeWayComparator<Compare, A, B>) {
+        return comp(first, second) < 0;
+    } else {
+        return comp(first, second);
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Форма дерева и счётчики операций с последнего resetStats().
+struct TreeStats {
+    size_t node_count = 0;
+    size_t height = 0;
+    // Число чёрных вершин на пути от корня до листа; для AVL — 0.
+    size_t black_height = 0;
+    size_t bytes_used = 0;
+    // Среднее число вершин на пути поиска существующего ключа (корень — глубина 1).
+    double average_depth = 0;
+    uint64_t rotations = 0;
+    uint64_t recolors = 0;
+    uint64_t comparisons = 0;
+};
+
+// Счётчики операций включаются макросом TREE_STATS: без него они пусты и не стоят
+// ничего, с ним — атомарные, чтобы параллельные читатели (ConcurrentMap) считались
+// без гонок. При копировании дерева счётчики начинаются с нуля.
+class TreeCounters {
+public:
+    TreeCounters() {
+    }
+    TreeCounters(const TreeCounters&) {
+    }
+    TreeCounters& operator=(const TreeCounters&) {
+        return *this;
+    }
+
+#ifdef TREE_STATS
+    void addRotation() const {
+        rotations_.fetch_add(1, std::memory_order_relaxed);
+    }
+    void addRecolor() const {
+        recolors_.fetch_add(1, std::memory_order_relaxed);
+    }
+    void addComparison() const {
+        comparisons_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void fill(TreeStats& stats) const {
+        stats.rotations = rotations_.load(std::memory_order_relaxed);
+        stats.recolors = recolors_.load(std::memory_order_relaxed);
+        stats.comparisons = comparisons_.load(std::memory_order_relaxed);
+    }
+
+    void reset() {
+        rotations_.store(0, std::memory_order_relaxed);
+        recolors_.store(0, std::memory_order_relaxed);
+        comparisons_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    mutable std::atomic<uint64_t> rotations_{0};
+    mutable std::atomic<uint64_t> recolors_{0};
+    mutable std::atomic<uint64_t> comparisons_{0};
+#else
+    void addRotation() const {
+    }
+    void addRecolor() const {
+    }
+    void addComparison() const {
+    }
+    void fill(TreeStats&) const {
+    }
+    void reset() {
+    }
+#endif
+};
+
+template <typename NodeType>
+void collectShape(const NodeType* node, size_t depth, TreeStats& stats, size_t& depth_sum) {
+    if (!node) {
+        return;
+    }
+    ++stats.node_count;
+    stats.height = std::max(stats.height, depth);
+    depth_sum += depth;
+    collectShape(node->left, depth + 1, stats, depth_sum);
+    collectShape(node->right, depth + 1, stats, depth_sum);
+}
+
+// Заполняет node_count, height и average_depth обходом поддерева node.
+template <typename NodeType>
+void collectShape(const NodeType* node, TreeStats& stats) {
+    size_t depth_sum = 0;
+    collectShape(node, 1, stats, depth_sum);
+    if (stats.node_count > 0) {
+        stats.average_depth = static_cast<double>(depth_sum) / stats.node_count;
+    }
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "set.cpp"
+
+// Квантили по скользящему окну из последних window отсчётов. Отсчёты хранятся
+// в дереве порядковых статистик парами (значение, номер поступления), поэтому
+// одинаковые значения не склеиваются, а самый старый отсчёт удаляется за O(log n)
+// по паре, сохранённой в кольцевом буфере.
+template <typename T>
+class WindowedQuantiles {
+public:
+    explicit WindowedQuantiles(size_t window) : window_(window), head_(0), next_seq_(0) {
+        if (window_ == 0) {
+            throw std::invalid_argument("WindowedQuantiles: window must be positive");
+        }
+        ring_.reserve(window_);
+    }
+
+    WindowedQuantiles(const WindowedQuantiles&) = delete;
+    WindowedQuantiles& operator=(const WindowedQuantiles&) = delete;
+
+    // Добавляет отсчёт; если окно заполнено, вытесняет самый старый.
+    void add(const T& sample) {
+        Sample entry = {sample, next_seq_++};
+        if (ring_.size() < window_) {
+            ring_.push_back(entry);
+        } else {
+            tree_.erase(ring_[head_]);
+            ring_[head_] = entry;
+            head_ = (head_ + 1) % window_;
+        }
+        tree_.insert(entry);
+    }
+
+    size_t size() const {
+        return tree_.size();
+    }
+    bool empty() const {
+        return tree_.empty();
+    }
+
+    // Квантиль q из [0, 1]: элемент с номером floor(q * (size - 1)) по возрастанию.
+    T quantile(double q) const {
+        T res;
+        quantiles(std::span<const double>(&q, 1), std::span<T>(&res, 1));
+        return res;
+    }
+
+    // Несколько квантилей за один общий спуск по дереву; qs может идти в любом порядке.
+    void quantiles(std::span<const double> qs, std::span<T> out) const {
+        if (tree_.empty()) {
+            throw std::out_of_range("WindowedQuantiles: window is empty");
+        }
+        if (out.size() < qs.size()) {
+            throw std::invalid_argument("WindowedQuantiles: output is too short");
+        }
+        std::vector<size_t> order(qs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(),
+                  [&qs](size_t first, size_t second) { return qs[first] < qs[second]; });
+
+        std::vector<size_t> ranks(qs.size());
+        for (size_t i = 0; i < qs.size(); ++i) {
+            ranks[i] = rankOf(qs[order[i]]);
+        }
+        std::vector<Sample> found(qs.size());
+        tree_.selectMany(ranks, found);
+        for (size_t i = 0; i < qs.size(); ++i) {
+            out[order[i]] = found[i].first;
+        }
+    }
+
+private:
+    using Sample = std::pair<T, uint64_t>;
+
+    size_t window_;
+    RBTree<Sample> tree_;
+    std::vector<Sample> ring_;
+    size_t head_;
+    uint64_t next_seq_;
+
+    size_t rankOf(double q) const {
+        if (!(q >= 0.0 && q <= 1.0)) {
+            throw std::out_of_range("WindowedQuantiles: quantile must be in [0, 1]");
+        }
+        return static_cast<size_t>(std::floor(q * static_cast<double>(tree_.size() - 1)));
+    }
+};